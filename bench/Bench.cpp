@@ -0,0 +1,512 @@
+//
+//  Bench.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "Bench.hpp"
+#include "../srcs/helpers/Perlin.hpp"
+#include "../srcs/helpers/Vector3f.hpp"
+#include "../srcs/includes/Shape.hpp"
+#include "../srcs/includes/Heightfield.hpp"
+#include "../srcs/includes/Colliders.hpp"
+#include "../srcs/includes/Picking.hpp"
+#include "../srcs/includes/SpatialIndex.hpp"
+#include "../srcs/includes/Camera.hpp"
+#include "../srcs/includes/Waves.hpp"
+#include "../srcs/includes/Lod.hpp"
+
+// HARNESS
+
+void Bench::add(const std::string &name, Body body) {
+  registry().emplace_back(name, std::move(body));
+}
+
+std::vector<std::pair<std::string, Bench::Body> > &Bench::registry() {
+  static std::vector<std::pair<std::string, Body> > benchmarks;
+  return benchmarks;
+}
+
+Bench::Result Bench::measure(const std::string &name, const Body &body) {
+  auto time = [&body](long iterations) {
+    auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  long iterations = 1;
+  while (time(iterations) < BENCH_MIN_TIME && iterations < (1L << 40)) {
+    iterations *= 2;
+  }
+
+  std::vector<double> samples;
+  for (int i = 0; i < BENCH_SAMPLES; ++i) {
+    samples.push_back(time(iterations) * 1e9 / iterations);
+  }
+  std::sort(samples.begin(), samples.end());
+  return {name, iterations, samples[samples.size() / 2], samples.front()};
+}
+
+bool Bench::writeJson(const std::string &path, const std::vector<Result> &results) {
+  FILE *file = path == "-" ? stdout : fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    perror(path.c_str());
+    return false;
+  }
+  fprintf(file, "{\"benchmarks\":[");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    fprintf(file, "%s\n{\"name\":\"%s\",\"iterations\":%ld,\"ns_per_op\":%.3f,\"min_ns_per_op\":%.3f}",
+            i ? "," : "", r.name.c_str(), r.iterations, r.nsPerOp, r.minNsPerOp);
+  }
+  fprintf(file, "\n]}\n");
+  if (file != stdout) {
+    fclose(file);
+  }
+  return true;
+}
+
+int Bench::main(int argc, char **argv) {
+  std::string filter, json;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--json") && i + 1 < argc) {
+      json = argv[++i];
+    } else {
+      filter = argv[i];
+    }
+  }
+
+  std::vector<Result> results;
+  for (auto &benchmark : registry()) {
+    if (benchmark.first.find(filter) == std::string::npos) {
+      continue;
+    }
+    results.push_back(measure(benchmark.first, benchmark.second));
+    // The table goes to stderr so `--json -` stays parseable
+    fprintf(stderr, "%-32s %12.1f ns/op %12ld iterations\n", results.back().name.c_str(), results.back().nsPerOp,
+            results.back().iterations);
+  }
+  return json.empty() || writeJson(json, results) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// FIXTURES
+
+static Shape subdividedShape(int depth) {
+  Vertex::Ptr a = std::make_shared<Vertex>(Vector3f(0.05f, 0.025f, -0.025f));
+  Vertex::Ptr b = std::make_shared<Vertex>(Vector3f(0.05f, 0.025f, 0.025f));
+  Vertex::Ptr c = std::make_shared<Vertex>(Vector3f(-0.05f, 0.025f, -0.025f));
+  Vertex::Ptr d = std::make_shared<Vertex>(Vector3f(0.0f, -0.025f, 0.025f));
+  Triangles triangles;
+  Triangle(a, b, c).subdivide(depth, triangles);
+  Triangle(c, b, d).subdivide(depth, triangles);
+  Shape shape(std::move(triangles));
+  shape.generateBoundingBox();
+  return shape;
+}
+
+/// Same size and noise as the island
+static Heightfield islandHeightfield() {
+  const int resolution = 64;
+  std::vector<float> heights;
+  for (int i = 0; i <= resolution; ++i) {
+    for (int j = 0; j <= resolution; ++j) {
+      heights.push_back(perlin2d(j * 0.2f / resolution * 500.0f, i * 0.2f / resolution * 500.0f, 0.03f, 8) * 0.1f);
+    }
+  }
+  return Heightfield(Vector3f(-0.1f, 0.0f, -0.1f), 0.2f / resolution, resolution, std::move(heights));
+}
+
+// VECTOR3F
+
+BENCHMARK(vector_rotation_matrix) {
+  float m[16];
+  Vector3f angle(0.1f, 0.2f, 0.3f);
+  for (long i = 0; i < iterations; ++i) {
+    angle.x += 1e-6f;
+    Bench::keep(angle.toRotationMatrix(m)[0]);
+  }
+}
+
+BENCHMARK(vector_mult_matrix) {
+  float a[16], b[16], result[16];
+  Vector3f(0.1f, 0.2f, 0.3f).toRotationMatrix(a);
+  Vector3f(0.4f, 0.5f, 0.6f).toTranslationMatrix(b);
+  for (long i = 0; i < iterations; ++i) {
+    Vector3f::multMatrix(a, b, result);
+    Bench::keep(result[0]);
+    a[12] = result[15];
+  }
+}
+
+BENCHMARK(vector_transform) {
+  float m[16];
+  Vector3f(0.1f, 0.2f, 0.3f).toRotationMatrix(m);
+  Vector3f v(0.5f, 0.25f, 0.75f);
+  for (long i = 0; i < iterations; ++i) {
+    Vector3f r = v * m;
+    Bench::keep(r);
+  }
+}
+
+// WAVES
+
+BENCHMARK(waves_compute_height) {
+  for (long i = 0; i < iterations; ++i) {
+    float x = (i % 256) / 128.0f - 1.0f;
+    float z = (i / 256 % 256) / 128.0f - 1.0f;
+    Bench::keep(Waves::computeHeight(x, z));
+  }
+}
+
+BENCHMARK(waves_compute_slope) {
+  for (long i = 0; i < iterations; ++i) {
+    float x = (i % 256) / 128.0f - 1.0f;
+    float z = (i / 256 % 256) / 128.0f - 1.0f;
+    Bench::keep(Waves::computeSlope(x, z));
+  }
+}
+
+// ISLAND
+
+BENCHMARK(perlin_2d) {
+  for (long i = 0; i < iterations; ++i) {
+    Bench::keep(perlin2d((i % 512) * 0.5f, (i / 512 % 512) * 0.5f, 0.03f, 8));
+  }
+}
+
+// GEOMETRY
+
+BENCHMARK(triangle_subdivide) {
+  Vertex::Ptr a = std::make_shared<Vertex>(Vector3f(0.0f, 0.0f, 0.0f));
+  Vertex::Ptr b = std::make_shared<Vertex>(Vector3f(1.0f, 0.0f, 0.0f));
+  Vertex::Ptr c = std::make_shared<Vertex>(Vector3f(0.0f, 1.0f, 0.0f));
+  Triangles triangles;
+  for (long i = 0; i < iterations; ++i) {
+    triangles.clear();
+    Triangle(a, b, c).subdivide(2, triangles);
+    Bench::keep(triangles.back().n);
+  }
+}
+
+BENCHMARK(shape_per_vertex_normal) {
+  Shape shape = subdividedShape(3);
+  for (long i = 0; i < iterations; ++i) {
+    shape.computePerVertexNormal();
+    Bench::keep(shape._parts.front().v1->n);
+  }
+}
+
+BENCHMARK(shape_bounding_box) {
+  Shape shape = subdividedShape(3);
+  for (long i = 0; i < iterations; ++i) {
+    shape.generateBoundingBox();
+    Bench::keep(shape.get_boundingBox());
+  }
+}
+
+BENCHMARK(shape_collide_with_shape) {
+  Shape a = subdividedShape(1);
+  Shape b = subdividedShape(1);
+  for (long i = 0; i < iterations; ++i) {
+    Bench::keep(a.collideWith(b));
+  }
+}
+
+BENCHMARK(shape_collide_with_box) {
+  Shape a = subdividedShape(1);
+  BoundingBox box(Vector3f(0.0f, 0.0f, 0.0f), Vector3f(0.01f, 0.01f, 0.01f));
+  for (long i = 0; i < iterations; ++i) {
+    box.vecMin.x = (i % 64) / 640.0f;
+    Bench::keep(a.collideWith(box));
+  }
+}
+
+// COLLIDERS
+
+/// 256 small shapes on a grid, the per pair path the box table replaces
+static std::vector<Shape> scatteredShapes() {
+  std::vector<Shape> shapes;
+  for (int i = 0; i < 256; ++i) {
+    Vertex::Ptr a = std::make_shared<Vertex>(Vector3f((i % 16) / 8.0f - 1.0f, 0.0f, (i / 16) / 8.0f - 1.0f));
+    Vertex::Ptr b = std::make_shared<Vertex>(a->p + Vector3f(0.05f, 0.02f, 0.0f));
+    Vertex::Ptr c = std::make_shared<Vertex>(a->p + Vector3f(0.0f, 0.02f, 0.05f));
+    Triangles triangles;
+    triangles.emplace_back(a, b, c);
+    triangles.emplace_back(c, b, a);
+    triangles.emplace_back(b, c, a);
+    shapes.emplace_back(std::move(triangles));
+    shapes.back().generateBoundingBox();
+  }
+  return shapes;
+}
+
+BENCHMARK(aabb_pairs_256) {
+  static const std::vector<Shape> shapes = scatteredShapes();
+  BoundingBox hull(Vector3f(0.0f, -0.01f, 0.0f), Vector3f(0.1f, 0.04f, 0.05f));
+  unsigned char hits[256];
+  for (long i = 0; i < iterations; ++i) {
+    for (size_t s = 0; s < shapes.size(); ++s) {
+      hits[s] = static_cast<unsigned char>(shapes[s].collideWith(hull));
+    }
+    Bench::keep(hits[i % 256]);
+  }
+}
+
+BENCHMARK(aabb_batch_256) {
+  static const std::vector<Shape> shapes = scatteredShapes();
+  AlignedBoxes boxes;
+  for (size_t s = 0; s < shapes.size(); ++s) {
+    boxes.push(shapes[s].get_boundingBox(), static_cast<int>(s));
+  }
+  BoundingBox hull(Vector3f(0.0f, -0.01f, 0.0f), Vector3f(0.1f, 0.04f, 0.05f));
+  unsigned char hits[256];
+  for (long i = 0; i < iterations; ++i) {
+    Colliders::overlap(hull, boxes, hits);
+    Bench::keep(hits[i % 256]);
+  }
+}
+
+/// 256 boat sized boxes turned every which way around the origin
+static OrientedBoxes scatteredBoxes() {
+  OrientedBoxes boxes;
+  BoundingBox hull(Vector3f(-0.05f, -0.025f, -0.025f), Vector3f(0.05f, 0.025f, 0.025f));
+  for (int i = 0; i < 256; ++i) {
+    Orientation orientation = Orientation::fromAngles(Vector3f(i % 7 * 5.0f, i * 37.0f, i % 5 * 5.0f));
+    boxes.push(OrientedBox(hull, Vector3f((i % 16) / 8.0f - 1.0f, 0.0f, (i / 16) / 8.0f - 1.0f), orientation), i);
+  }
+  return boxes;
+}
+
+BENCHMARK(obb_overlap_obb) {
+  static const OrientedBoxes boxes = scatteredBoxes();
+  OrientedBox a = boxes.get(0);
+  for (long i = 0; i < iterations; ++i) {
+    Bench::keep(Colliders::overlap(a, boxes.get(static_cast<size_t>(i % 256))));
+  }
+}
+
+BENCHMARK(obb_overlap_capsule) {
+  static const OrientedBoxes boxes = scatteredBoxes();
+  Capsule shell{Vector3f(-0.5f, 0.1f, -0.5f), Vector3f(-0.45f, -0.01f, -0.48f), 0.02f};
+  for (long i = 0; i < iterations; ++i) {
+    Bench::keep(Colliders::overlap(boxes.get(static_cast<size_t>(i % 256)), shell));
+  }
+}
+
+BENCHMARK(obb_sphere_scalar_256) {
+  static const OrientedBoxes boxes = scatteredBoxes();
+  Sphere shell{Vector3f(0.1f, 0.0f, 0.1f), 0.05f};
+  unsigned char hits[256];
+  for (long i = 0; i < iterations; ++i) {
+    for (size_t b = 0; b < boxes.size(); ++b) {
+      hits[b] = static_cast<unsigned char>(Colliders::overlap(boxes.get(b), shell));
+    }
+    Bench::keep(hits[i % 256]);
+  }
+}
+
+BENCHMARK(obb_sphere_batch_256) {
+  static const OrientedBoxes boxes = scatteredBoxes();
+  Sphere shell{Vector3f(0.1f, 0.0f, 0.1f), 0.05f};
+  unsigned char hits[256];
+  for (long i = 0; i < iterations; ++i) {
+    Colliders::overlap(shell, boxes, hits);
+    Bench::keep(hits[i % 256]);
+  }
+}
+
+// HEIGHTFIELD
+
+BENCHMARK(heightfield_segment) {
+  static const Heightfield ground = islandHeightfield();
+  float t;
+  for (long i = 0; i < iterations; ++i) {
+    float x = (i % 64) / 320.0f - 0.1f;
+    Bench::keep(ground.intersectSegment(Vector3f(x, 0.2f, -0.15f), Vector3f(-x, -0.05f, 0.15f), t));
+  }
+}
+
+BENCHMARK(heightfield_sphere) {
+  static const Heightfield ground = islandHeightfield();
+  for (long i = 0; i < iterations; ++i) {
+    float x = (i % 64) / 320.0f - 0.1f;
+    Bench::keep(ground.overlapsSphere(Vector3f(x, 0.05f, x * 0.5f), 0.02f));
+  }
+}
+
+// PICKING
+
+/// Boats in rings around the island, the fleet a cursor ray has to search, with its index
+struct Fleet {
+  explicit Fleet(int count) {
+    BoundingBox hull(Vector3f(-0.05f, -0.025f, -0.025f), Vector3f(0.05f, 0.025f, 0.025f));
+    owners.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+      float angle = i * 2.39996f, distance = 0.25f + 0.7f * i / count;
+      owners.emplace_back(Vector3f(std::cos(angle) * distance, 0.0f, std::sin(angle) * distance));
+      Components::Handle handle = components.create(&owners.back(), BOAT_LAYER);
+      components.bounds[handle] = hull;
+      components.orientations[handle] = Orientation::fromAngles(Vector3f(0.0f, angle * 57.3f, 0.0f));
+    }
+    Systems::colliders(components, 0, components.size());
+    index.build(components);
+  }
+
+  std::vector<Displayable> owners;
+  Components components;
+  SpatialIndex index;
+};
+
+/// Rays from the camera's start sweeping down across the island and the sea
+static Ray cursorRay(long i) {
+  float x = (i % 32) / 16.0f - 1.0f, y = -(i / 32 % 16) / 16.0f;
+  return Ray{Vector3f(-0.01f, 0.53f, -0.01f), Vector3f(x, y - 0.6f, 1.0f)};
+}
+
+BENCHMARK(pick_ocean) {
+  float t;
+  for (long i = 0; i < iterations; ++i) {
+    Bench::keep(Picking::ocean(cursorRay(i), 3.0f, t));
+  }
+}
+
+BENCHMARK(pick_boats_512) {
+  static const Fleet fleet(512);
+  float t;
+  int id;
+  for (long i = 0; i < iterations; ++i) {
+    Bench::keep(Picking::boats(cursorRay(i), 3.0f, fleet.index, fleet.components, t, id));
+  }
+}
+
+BENCHMARK(pick_512) {
+  static const Heightfield ground = islandHeightfield();
+  static const Fleet fleet(512);
+  for (long i = 0; i < iterations; ++i) {
+    Bench::keep(Picking::pick(cursorRay(i), 3.0f, &ground, fleet.index, fleet.components).distance);
+  }
+}
+
+// SPATIAL INDEX
+
+/// 512 boats spread over the sea and 64 shells, the owners only lend their starting positions
+static const Components &fleetComponents() {
+  static std::vector<Displayable> owners;
+  static Components components;
+  if (owners.empty()) {
+    owners.reserve(576);
+    for (int i = 0; i < 576; ++i) {
+      float angle = i * 2.39996f, distance = 0.1f + 0.85f * (i % 512) / 512.0f;
+      owners.emplace_back(Vector3f(std::cos(angle) * distance, i < 512 ? 0.0f : 0.2f, std::sin(angle) * distance));
+      components.create(&owners.back(), i < 512 ? BOAT_LAYER : PLAYER_SHELL_LAYER);
+    }
+  }
+  return components;
+}
+
+BENCHMARK(spatial_build_576) {
+  const Components &components = fleetComponents();
+  SpatialIndex index;
+  for (long i = 0; i < iterations; ++i) {
+    index.build(components);
+    Bench::keep(index.size());
+  }
+}
+
+BENCHMARK(spatial_nearest_8) {
+  const Components &components = fleetComponents();
+  SpatialIndex index;
+  index.build(components);
+  int ids[8];
+  for (long i = 0; i < iterations; ++i) {
+    Vector3f p((i % 64) / 32.0f - 1.0f, 0.0f, (i / 64 % 64) / 32.0f - 1.0f);
+    Bench::keep(index.nearest(p, LAYER(BOAT_LAYER), 2.0f, ids, 8));
+  }
+}
+
+/// The scan the index replaces, every live boat measured then partially sorted
+BENCHMARK(scan_nearest_8) {
+  const Components &components = fleetComponents();
+  std::vector<std::pair<float, int> > all;
+  for (long i = 0; i < iterations; ++i) {
+    Vector3f p((i % 64) / 32.0f - 1.0f, 0.0f, (i / 64 % 64) / 32.0f - 1.0f);
+    all.clear();
+    for (size_t c = 0; c < components.size(); ++c) {
+      if ((components.flags[c] & Components::ALIVE) && components.layers[c] == BOAT_LAYER) {
+        Vector3f d = components.positions[c] - p;
+        all.emplace_back(d.x * d.x + d.y * d.y + d.z * d.z, static_cast<int>(c));
+      }
+    }
+    std::partial_sort(all.begin(), all.begin() + 8, all.end());
+    Bench::keep(all.front().second);
+  }
+}
+
+BENCHMARK(spatial_radius) {
+  const Components &components = fleetComponents();
+  SpatialIndex index;
+  index.build(components);
+  for (long i = 0; i < iterations; ++i) {
+    Vector3f p((i % 64) / 32.0f - 1.0f, 0.0f, (i / 64 % 64) / 32.0f - 1.0f);
+    int count = 0;
+    index.forEachInRadius(p, 0.15f, LAYER(BOAT_LAYER), [&count](int, const Vector3f &, const Vector3f &) {
+      ++count;
+    });
+    Bench::keep(count);
+  }
+}
+
+BENCHMARK(spatial_cone) {
+  const Components &components = fleetComponents();
+  SpatialIndex index;
+  index.build(components);
+  for (long i = 0; i < iterations; ++i) {
+    float angle = (i % 360) * 0.01745f;
+    Vector3f axis(std::cos(angle), 0.0f, std::sin(angle));
+    int count = 0;
+    index.forEachInCone(Vector3f(), axis, 30.0f, 0.4f, LAYER(BOAT_LAYER),
+                        [&count](int, const Vector3f &, const Vector3f &) { ++count; });
+    Bench::keep(count);
+  }
+}
+
+// CULLING
+
+/// The default camera's view, looking down at the island
+static Frustum startFrustum() {
+  return Camera().frustum();
+}
+
+BENCHMARK(frustum_ocean_chunks_64) {
+  static const Frustum frustum = startFrustum();
+  int visible = 0;
+  for (long i = 0; i < iterations; ++i) {
+    for (int c = 0; c < 64; ++c) {
+      float x = (c % 8) / 4.0f - 1.0f, z = (c / 8) / 4.0f - 1.0f;
+      visible += frustum.box(BoundingBox(Vector3f(x, -0.13f, z), Vector3f(x + 0.25f, 0.13f, z + 0.25f)));
+    }
+  }
+  Bench::keep(visible);
+}
+
+BENCHMARK(lod_select_256) {
+  static const Frustum frustum = startFrustum();
+  static int levels[256] = {};
+  int coarse = 0;
+  for (long i = 0; i < iterations; ++i) {
+    for (int s = 0; s < 256; ++s) {
+      Vector3f p((s % 16) / 8.0f - 1.0f, 0.0f, (s / 16) / 8.0f - 1.0f);
+      levels[s] = Lod::select(frustum.screenSize(p, 0.02f), 2.0f * M_PI, 20, levels[s]);
+      coarse += levels[s];
+    }
+  }
+  Bench::keep(coarse);
+}
+
+int main(int argc, char **argv) {
+  return Bench::main(argc, argv);
+}
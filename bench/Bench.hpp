@@ -0,0 +1,57 @@
+//
+//  Bench.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/// Minimal benchmark harness.
+/// Each benchmark receives an iteration count and runs its kernel that many
+/// times. The harness doubles the count until one run lasts BENCH_MIN_TIME,
+/// then keeps the median of BENCH_SAMPLES runs.
+class Bench {
+public:
+  typedef std::function<void(long iterations)> Body;
+
+  struct Result {
+    std::string name;
+    long iterations;
+    double nsPerOp, minNsPerOp;
+  };
+
+  struct Registrar {
+    Registrar(const char *name, Body body) {
+      Bench::add(name, std::move(body));
+    }
+  };
+
+  static void add(const std::string &name, Body body);
+
+  /// bench [filter] [--json file|-], returns the process exit code
+  static int main(int argc, char **argv);
+
+  /// Keeps the compiler from optimising away a value
+  template<class T>
+  static void keep(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+  }
+
+private:
+  static std::vector<std::pair<std::string, Body> > &registry();
+
+  static Result measure(const std::string &name, const Body &body);
+
+  static bool writeJson(const std::string &path, const std::vector<Result> &results);
+};
+
+#define BENCH_MIN_TIME 0.2    // Seconds
+#define BENCH_SAMPLES 5
+
+#define BENCHMARK(name) \
+  static void name(long iterations); \
+  static Bench::Registrar name##Registrar(#name, name); \
+  static void name(long iterations)
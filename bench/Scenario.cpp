@@ -0,0 +1,208 @@
+//
+//  Scenario.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+#include "../srcs/includes/Game.hpp"
+#include "../srcs/includes/Island.hpp"
+#include "../srcs/includes/AllocTracker.hpp"
+#include "../srcs/includes/FramePacer.hpp"
+
+/// Headless end-to-end run: N boats attack while the island cannon follows a
+/// scripted sweep, for a fixed number of fixed-length ticks. A run where the
+/// island sinks stops there and fails, the load it was asked for is gone. So
+/// does a run where a boat waits longer for its think than the AI budget allows.
+/// With --pace, ticks are held to R per second like frames in the game, and
+/// the CPU figure shows how much of a core the paced loop still burns.
+/// scenario [--boats N] [--ticks T] [--warmup W] [--dt S] [--fire-every K] [--pace R] [--json file|-]
+///          [--preset name] [--config file] [--set key=value]
+struct Scenario {
+  int boats = 0;              // 0 keeps max_boats from the settings
+  int ticks = 2000;
+  int warmup = 200;           // Ticks left out of the statistics
+  float dt = 1.0f / 60.0f;
+  int fireEvery = 5;
+  int pace = 0;               // Ticks per second, 0 runs flat out
+  std::string json;
+};
+
+static bool parse(int argc, char **argv, Scenario &scenario) {
+  for (int i = 1; i < argc; ++i) {
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char *value = argv[++i];
+    if (!strcmp(argv[i - 1], "--boats")) {
+      scenario.boats = atoi(value);
+    } else if (!strcmp(argv[i - 1], "--ticks")) {
+      scenario.ticks = atoi(value);
+    } else if (!strcmp(argv[i - 1], "--warmup")) {
+      scenario.warmup = atoi(value);
+    } else if (!strcmp(argv[i - 1], "--dt")) {
+      scenario.dt = static_cast<float>(atof(value));
+    } else if (!strcmp(argv[i - 1], "--fire-every")) {
+      scenario.fireEvery = std::max(1, atoi(value));
+    } else if (!strcmp(argv[i - 1], "--pace")) {
+      scenario.pace = std::max(0, atoi(value));
+    } else if (!strcmp(argv[i - 1], "--json")) {
+      scenario.json = value;
+    } else {
+      return false;
+    }
+  }
+  return scenario.boats >= 0 && scenario.ticks > scenario.warmup && scenario.dt > 0.0f;
+}
+
+/// User and system time of every thread, in seconds
+static double cpuTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/// Peak resident set size in kilobytes
+static long peakRss() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#if __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+/// Boats still afloat
+static long boatCount(const Components &components) {
+  long count = 0;
+  for (size_t i = 0; i < components.size(); ++i) {
+    count += (components.flags[i] & Components::ALIVE) && components.layers[i] == BOAT_LAYER;
+  }
+  return count;
+}
+
+int main(int argc, char **argv) {
+  Scenario scenario;
+  if (!Settings::parseArguments(argc, argv) || !parse(argc, argv, scenario)) {
+    fprintf(stderr, "usage: %s [--boats N] [--ticks T] [--warmup W] [--dt S] [--fire-every K] [--pace R]"
+                    " [--json file|-]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  Game &game = Game::getInstance();
+  if (scenario.boats > 0) {
+    Settings::current.maxBoats = scenario.boats;
+    Settings::current.boatsPerGeneration = scenario.boats;
+  }
+  scenario.boats = MAX_BOATS;
+  Settings::current.frameRate = scenario.pace;
+  FramePacer pacer;
+  game.startHeadless();
+  auto island = std::dynamic_pointer_cast<Island>(game.getEntities().at(ISLAND));
+
+  std::vector<double> times;
+  times.reserve(static_cast<size_t>(scenario.ticks - scenario.warmup));
+  long allocations = 0, worstAllocations = 0;
+  long liveBoats = 0, peakBoats = 0;
+  int sunkAt = -1;
+  int longestWait = 0, starvedAt = -1;
+  auto start = std::chrono::steady_clock::now();
+  double cpuStart = cpuTime();
+  for (int tick = 0; tick < scenario.ticks; ++tick) {
+    if (tick == scenario.warmup) {
+      start = std::chrono::steady_clock::now();
+      cpuStart = cpuTime();
+    }
+    pacer.wait();
+
+    // Sweep the cannon around the island, then fire and defend like a player would
+    if (tick % scenario.fireEvery == 0) {
+      island->getCannon()->setAngle({0.0f, (tick * 7) % 360 * 1.0f, 0.0f});
+      island->getCannon()->setRotation(20.0f + (tick * 3) % 40);
+      island->getCannon()->blast(1);
+    }
+    if (tick % (scenario.fireEvery * 20) == 0) {
+      island->getCannon()->defend();
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    game.tick(scenario.dt);
+    auto end = std::chrono::steady_clock::now();
+
+    AllocTracker::endFrame();
+    if (tick >= scenario.warmup) {
+      times.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+      allocations += AllocTracker::lastTotal().count;
+      worstAllocations = std::max(worstAllocations, AllocTracker::lastTotal().count);
+      long live = boatCount(game.getComponents());
+      liveBoats += live;
+      peakBoats = std::max(peakBoats, live);
+    }
+    // Every agent gets a grant once the budget has gone round all of them
+    AIScheduler &scheduler = game.getScheduler();
+    longestWait = std::max(longestWait, scheduler.longestWait());
+    if (starvedAt < 0 && scheduler.longestWait() > (scheduler.agents() - 1) / AI_MAX_THINKS_PER_TICK) {
+      starvedAt = tick;
+    }
+    if (island->getCurrentHealth() == 0) {
+      sunkAt = tick;
+      break;
+    }
+  }
+  if (sunkAt >= 0 && sunkAt < scenario.warmup) {
+    fprintf(stderr, "island sunk at tick %d, during the warmup\n", sunkAt);
+    return EXIT_FAILURE;
+  }
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double cpu = (cpuTime() - cpuStart) / elapsed * 100.0;
+
+  std::vector<double> sorted = times;
+  std::sort(sorted.begin(), sorted.end());
+  auto percentile = [&sorted](double p) { return sorted[static_cast<size_t>((sorted.size() - 1) * p / 100.0)]; };
+  size_t measured = times.size();
+  bool withinBudget = worstAllocations <= ALLOC_FRAME_BUDGET;
+
+  fprintf(stderr, "boats %d, %zu ticks: %.1f ticks/s, p50 %.3f ms, p99 %.3f ms, cpu %.0f%%, peak rss %ld KB\n",
+          scenario.boats, measured, measured / elapsed, percentile(50.0), percentile(99.0), cpu, peakRss());
+  fprintf(stderr, "live boats: %.1f on average, peak %ld\n", static_cast<double>(liveBoats) / measured, peakBoats);
+  fprintf(stderr, "ai: longest wait for a think %d ticks\n", longestWait);
+  if (sunkAt >= 0) {
+    fprintf(stderr, "island sunk at tick %d of %d\n", sunkAt, scenario.ticks);
+  }
+  if (starvedAt >= 0) {
+    fprintf(stderr, "ai: a boat waited past the budget's round at tick %d\n", starvedAt);
+  }
+  if (AllocTracker::enabled()) {
+    fprintf(stderr, "allocations: %.1f per tick, worst %ld, budget %d%s\n",
+            static_cast<double>(allocations) / measured, worstAllocations, ALLOC_FRAME_BUDGET,
+            withinBudget ? "" : " EXCEEDED");
+  }
+
+  if (!scenario.json.empty()) {
+    FILE *file = scenario.json == "-" ? stdout : fopen(scenario.json.c_str(), "w");
+    if (file == nullptr) {
+      perror(scenario.json.c_str());
+      return EXIT_FAILURE;
+    }
+    fprintf(file, "{\"boats\":%d,\"ticks\":%zu,\"dt\":%.6f,\"ticks_per_sec\":%.3f,\"p50_ms\":%.4f,\"p99_ms\":%.4f,"
+                  "\"cpu_percent\":%.1f,\"peak_rss_kb\":%ld,\"live_boats\":%.2f,\"peak_boats\":%ld,\"sunk_at\":%d,"
+                  "\"allocations\":%s,\"allocations_per_tick\":%s}\n",
+            scenario.boats, measured, scenario.dt, measured / elapsed, percentile(50.0), percentile(99.0), cpu,
+            peakRss(), static_cast<double>(liveBoats) / measured, peakBoats, sunkAt, AllocTracker::enabled() ? std::to_string(allocations).c_str() : "null",
+            AllocTracker::enabled() ? std::to_string(static_cast<double>(allocations) / measured).c_str() : "null");
+    if (file != stdout) {
+      fclose(file);
+    }
+  }
+
+  // A tracked run fails when a steady state tick goes over the allocation budget
+  return sunkAt >= 0 || starvedAt >= 0 || (AllocTracker::enabled() && !withinBudget) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -10,6 +10,9 @@
 #include "srcs/includes/Game.hpp"
 
 int main(int argc, char **argv) {
+  if (!Settings::parseArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
   Game::getInstance().start(argc, argv);
   return EXIT_SUCCESS;
 }
\ No newline at end of file
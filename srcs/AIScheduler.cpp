@@ -0,0 +1,93 @@
+//
+//  AIScheduler.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "includes/AIScheduler.hpp"
+#include "includes/Config.hpp"
+
+AIScheduler::AIScheduler() : _enrolled(0), _thinks(0), _agents(0), _longestWait(0), _cursor(0) {}
+
+void AIScheduler::beginTick(float now) {
+  // The scan starts past the last slot granted, so the budget goes round every due agent in turn
+  _thinks = 0;
+  _longestWait = 0;
+  size_t next = _cursor;
+  for (size_t n = 0; n < _slots.size(); ++n) {
+    size_t i = (_cursor + n) % _slots.size();
+    Slot &slot = _slots[i];
+    bool due = slot.used && now >= slot.nextThink;
+    slot.granted = due && _thinks < AI_MAX_THINKS_PER_TICK;
+    if (slot.granted) {
+      ++_thinks;
+      slot.waited = 0;
+      next = i + 1;
+    } else if (due) {
+      _longestWait = std::max(_longestWait, ++slot.waited);
+    }
+  }
+  _cursor = _slots.empty() ? 0 : next % _slots.size();
+}
+
+AIScheduler::Ticket AIScheduler::enroll(float now) {
+  // Golden ratio sequence: consecutive agents land far apart inside the interval
+  float phase = std::fmod(_enrolled++ * 0.618034f, 1.0f) * AI_THINK_INTERVAL / GAME_SPEED;
+  Slot slot = {now + phase, now, true, false, 0};
+  ++_agents;
+
+  if (!_free.empty()) {
+    Ticket ticket = _free.back();
+    _free.pop_back();
+    _slots[ticket] = slot;
+    return ticket;
+  }
+  _slots.push_back(slot);
+  return static_cast<Ticket>(_slots.size() - 1);
+}
+
+void AIScheduler::release(Ticket ticket) {
+  if (ticket < 0 || ticket >= _slots.size() || !_slots[ticket].used) {
+    return;
+  }
+  _slots[ticket].used = false;
+  _free.push_back(ticket);
+  --_agents;
+}
+
+bool AIScheduler::shouldThink(Ticket ticket, float now, float distance, float &elapsed) {
+  Slot &slot = _slots[ticket];
+  if (!slot.granted) {
+    return false;
+  }
+  slot.granted = false;
+  elapsed = now - slot.lastThink;
+  slot.lastThink = now;
+  slot.nextThink = now + interval(distance);
+  return true;
+}
+
+int AIScheduler::thinksThisTick() const {
+  return _thinks;
+}
+
+int AIScheduler::agents() const {
+  return _agents;
+}
+
+int AIScheduler::longestWait() const {
+  return _longestWait;
+}
+
+float AIScheduler::chance(float rate, float dt) {
+  return 1.0f - std::exp(-rate * dt);
+}
+
+float AIScheduler::interval(float distance) const {
+  float lod = (distance - AI_LOD_NEAR) / (AI_LOD_FAR - AI_LOD_NEAR);
+  lod = lod < 0.0f ? 0.0f : lod;
+  lod = lod > 1.0f ? 1.0f : lod;
+  return AI_THINK_INTERVAL / GAME_SPEED * (1.0f + lod * (AI_LOD_MAX_SCALE - 1.0f));
+}
@@ -0,0 +1,81 @@
+//
+//  AllocTracker.cpp
+//  IslandDefense3D
+//
+
+#include <cstdlib>
+#include <new>
+
+#include "includes/AllocTracker.hpp"
+#include "includes/JobSystem.hpp"
+
+AllocTracker::Row AllocTracker::_rows[MAX_THREADS];
+AllocTracker::Counter AllocTracker::_last[TAGS];
+thread_local int AllocTracker::_tag = AllocTracker::UNTAGGED;
+
+#ifdef ALLOC_TRACKING
+
+void *operator new(size_t size) {
+  AllocTracker::record(size);
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+#endif
+
+bool AllocTracker::enabled() {
+#ifdef ALLOC_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AllocTracker::record(size_t bytes) {
+  unsigned int thread = JobSystem::currentThread();
+  Row &row = _rows[thread < MAX_THREADS ? thread : MAX_THREADS - 1];
+  row.count[_tag].fetch_add(1, std::memory_order_relaxed);
+  row.bytes[_tag].fetch_add(static_cast<long>(bytes), std::memory_order_relaxed);
+}
+
+int AllocTracker::currentTag() {
+  return _tag;
+}
+
+void AllocTracker::setTag(int tag) {
+  _tag = tag;
+}
+
+void AllocTracker::endFrame() {
+  for (int tag = 0; tag < TAGS; ++tag) {
+    _last[tag] = Counter();
+    for (Row &row : _rows) {
+      _last[tag].count += row.count[tag].exchange(0, std::memory_order_relaxed);
+      _last[tag].bytes += row.bytes[tag].exchange(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+const AllocTracker::Counter &AllocTracker::last(int tag) {
+  return _last[tag];
+}
+
+AllocTracker::Counter AllocTracker::lastTotal() {
+  Counter total = Counter();
+  for (const Counter &counter : _last) {
+    total.count += counter.count;
+    total.bytes += counter.bytes;
+  }
+  return total;
+}
+
+bool AllocTracker::withinBudget() {
+  return lastTotal().count <= ALLOC_FRAME_BUDGET;
+}
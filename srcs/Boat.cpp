@@ -10,42 +10,75 @@
 #include "includes/Waves.hpp"
 #include "includes/Game.hpp"
 #include "includes/Island.hpp"
+#include "includes/Collisions.hpp"
+#include "includes/FrameArena.hpp"
+
+/// Every boat shares one hull, only the triangle array is copied per boat
+static const Triangles &hull() {
+  static const Triangles triangles = []() {
+    Vertex::Ptr ttr = std::make_shared<Vertex>(Vector3f(0.05f, 0.025f, -0.025f));
+    Vertex::Ptr ttl = std::make_shared<Vertex>(Vector3f(0.05f, 0.025f, 0.025f));
+    Vertex::Ptr tbr = std::make_shared<Vertex>(Vector3f(-0.05f, 0.025f, -0.025f));
+    Vertex::Ptr tbl = std::make_shared<Vertex>(Vector3f(-0.05f, 0.025f, 0.025f));
+    Vertex::Ptr bbr = std::make_shared<Vertex>(Vector3f(0.0f, -0.025f, -0.025f));
+    Vertex::Ptr bbl = std::make_shared<Vertex>(Vector3f(0.0f, -0.025f, 0.025f));
+
+    Triangles triangles;
+    Triangle(ttr, ttl, tbl).subdivide(2, triangles); // TOP
+    Triangle(tbl, tbr, ttr).subdivide(2, triangles); // TOP
+    Triangle(ttl, ttr, bbr).subdivide(2, triangles); // FRONT
+    Triangle(bbr, bbl, ttl).subdivide(2, triangles); // FRONT
+    Triangle(tbr, tbl, bbl).subdivide(2, triangles); // BACK
+    Triangle(bbl, bbr, tbr).subdivide(2, triangles); // BACK
+    Triangle(tbl, ttl, bbl).subdivide(2, triangles); // LEFT
+    Triangle(ttr, tbr, bbr).subdivide(2, triangles); // RIGHT
+    Shape shape = Shape(std::move(triangles));
+    shape.computePerVertexNormal();
+    return std::move(shape._parts);
+  }();
+  return triangles;
+}
 
 Boat::Boat(const Color color, const Vector3f startPos) : Alive(BOATS_BASE_HEALTH), Movable(BOAT_SPEED, startPos) {
-  Vertex::Ptr ttr = std::make_shared<Vertex>(Vector3f(0.05f, 0.025f, -0.025f));
-  Vertex::Ptr ttl = std::make_shared<Vertex>(Vector3f(0.05f, 0.025f, 0.025f));
-  Vertex::Ptr tbr = std::make_shared<Vertex>(Vector3f(-0.05f, 0.025f, -0.025f));
-  Vertex::Ptr tbl = std::make_shared<Vertex>(Vector3f(-0.05f, 0.025f, 0.025f));
-  Vertex::Ptr bbr = std::make_shared<Vertex>(Vector3f(0.0f, -0.025f, -0.025f));
-  Vertex::Ptr bbl = std::make_shared<Vertex>(Vector3f(0.0f, -0.025f, 0.025f));
-
-  Triangles triangles;
-  Triangle(ttr, ttl, tbl).subdivide(2, triangles); // TOP
-  Triangle(tbl, tbr, ttr).subdivide(2, triangles); // TOP
-  Triangle(ttl, ttr, bbr).subdivide(2, triangles); // FRONT
-  Triangle(bbr, bbl, ttl).subdivide(2, triangles); // FRONT
-  Triangle(tbr, tbl, bbl).subdivide(2, triangles); // BACK
-  Triangle(bbl, bbr, tbr).subdivide(2, triangles); // BACK
-  Triangle(tbl, ttl, bbl).subdivide(2, triangles); // LEFT
-  Triangle(ttr, tbr, bbr).subdivide(2, triangles); // RIGHT
-  Shape shape = Shape(triangles, _coordinates, GL_TRIANGLES, color);
-  shape.computePerVertexNormal();
+  Shape shape = Shape(hull(), _coordinates, GL_TRIANGLES, color);
   shape.generateBoundingBox();
-  _shapes.emplace_back(shape);
-  _cannon = std::make_shared<Cannon>(3.0f, 0.005f, color);
+  _shapes.emplace_back(std::move(shape));
+  _cannon = std::make_shared<Cannon>(3.0f, 0.005f, color, ENEMY_SHELL_LAYER, ENEMY_SHIELD_LAYER);
 
   std::uniform_real_distribution<float> dis(0.5f, 0.8f);
   std::random_device rd;
-  std::mt19937 gen(rd());
-  _duration = dis(gen);
+  _random.seed(rd());
+  _duration = dis(_random);
+
+  // The island sits at the origin, this holds until the first think
+  _look = Vector3f(startPos.x, 0, startPos.z).normalize();
+  _lastCollisionCheck = -CHECK_COLLISIONS_EVERY / GAME_SPEED;
+  _wantsBlast = _wantsDefend = false;
+  _ticket = Game::getInstance().getScheduler().enroll(Game::getInstance().getTime());
+
+  Components &components = Game::getInstance().getComponents();
+  _handle = components.create(this, BOAT_LAYER);
+  components.bounds[_handle] = _shapes.front().get_boundingBox();
+  components.bounds[_handle].vecMin = components.bounds[_handle].vecMin - _coordinates;
+  components.bounds[_handle].vecMax = components.bounds[_handle].vecMax - _coordinates;
+}
+
+Boat::~Boat() {
+  Game::getInstance().getScheduler().release(_ticket);
+  Game::getInstance().getComponents().destroy(_handle);
 }
 
 void Boat::draw() const {
+  // The cannon culls its barrel and its shells on its own
+  if (!GlState::visible(Game::getInstance().getFrustum().sphere(_coordinates, BOAT_CULL_RADIUS))) {
+    _cannon->draw();
+    return;
+  }
   if (Game::getInstance().getShowLight()) {
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_COLOR_MATERIAL);
-    glEnable(GL_NORMALIZE);
+    GlState::enable(GL_LIGHTING);
+    GlState::enable(GL_LIGHT0);
+    GlState::enable(GL_COLOR_MATERIAL);
+    GlState::enable(GL_NORMALIZE);
 
     GLfloat specular[] = {1.0f, 0.3f, 0.5f, 1.0f};
     glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
@@ -57,26 +90,26 @@ void Boat::draw() const {
     glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
   }
 
-  glEnable(GL_BLEND);
+  GlState::enable(GL_BLEND);
   glPushMatrix();
   GLfloat m[16];
   glMultMatrixf(_coordinates.toTranslationMatrix(m));
   glMultMatrixf((_angle * (M_PI / 180.0f)).toRotationMatrix(m));
   Displayable::draw();
   glPopMatrix();
-  glDisable(GL_BLEND);
+  GlState::disable(GL_BLEND);
 
   if (Game::getInstance().getShowLight()) {
-    glDisable(GL_NORMALIZE);
-    glDisable(GL_COLOR_MATERIAL);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_LIGHTING);
+    GlState::disable(GL_NORMALIZE);
+    GlState::disable(GL_COLOR_MATERIAL);
+    GlState::disable(GL_LIGHT0);
+    GlState::disable(GL_LIGHTING);
   }
 
   _cannon->draw();
 }
 
-void Boat::update() {
+void Boat::prepare() {
   _coordinates.y = Waves::computeHeight(_coordinates.x, _coordinates.z);
   float slope = Waves::computeSlope(_coordinates.x, _coordinates.z);
   _angle.z = static_cast<float>(std::atan(slope) * 180.0f / M_PI);
@@ -88,78 +121,156 @@ void Boat::update() {
   _cannon->setCoordinates(cannonPos);
 
   computeAI(cannonPos);
+
+  Components &components = Game::getInstance().getComponents();
+  components.velocities[_handle] = _look * (-_speed * 0.1f);
+  components.positions[_handle] = _coordinates;
+  components.orientations[_handle] = Orientation::fromAngles(_angle);
+}
+
+void Boat::detect() {
+  _cannon->detect();
+
+  // Check collisions
+  if (Game::getInstance().getTime() - _lastCollisionCheck > CHECK_COLLISIONS_EVERY / GAME_SPEED) {
+    _lastCollisionCheck = Game::getInstance().getTime();
+    checkCollisions();
+  }
 }
 
+void Boat::update() {
+  // Side effects decided in prepare(), applied in fleet order
+  if (_wantsBlast) {
+    _cannon->blast(4.0);
+  }
+  if (_wantsDefend) {
+    _cannon->defend();
+  }
+  _wantsBlast = _wantsDefend = false;
+  _cannon->update();
+}
 void Boat::computeAI(const Vector3f &cannonPos) {
   static Island::Ptr island = std::dynamic_pointer_cast<Island>(Game::getInstance().getEntities().at(ISLAND));
   Vector3f islandPos = island->getCoordinates();
-  Vector3f look = Vector3f(_coordinates.x - islandPos.x, 0, _coordinates.z - islandPos.z).normalize();
   Vector3f xAxis = Vector3f((islandPos.x + 1) - islandPos.x, 0, islandPos.z);
-  _coordinates.x -= look.x * _speed * 0.1f;
-  _coordinates.z -= look.z * _speed * 0.1f;
-  _angle.y = 180.0f + static_cast<float>((std::atan2(xAxis.z, xAxis.x) - std::atan2(look.z, look.x)) * 180.0f / M_PI);
+
+  float elapsed;
+  float distance = std::hypot(_coordinates.x - islandPos.x, _coordinates.z - islandPos.z);
+  bool thinking = Game::getInstance().getScheduler().shouldThink(_ticket, Game::getInstance().getTime(), distance,
+                                                                 elapsed);
+  if (thinking) {
+    steer(islandPos);
+  }
+  _coordinates.x -= _look.x * _speed * 0.1f;
+  _coordinates.z -= _look.z * _speed * 0.1f;
+  _angle.y = 180.0f + static_cast<float>((std::atan2(xAxis.z, xAxis.x) - std::atan2(_look.z, _look.x)) * 180.0f / M_PI);
 
   Vector3f v = Vector3f((islandPos.x - cannonPos.x) / _duration,
                         (islandPos.y + 0.2f - cannonPos.y - g * _duration * _duration / 2.0f) / _duration,
                         (islandPos.z - cannonPos.z) / _duration);
   _cannon->setAngle(_angle);
   _cannon->setRotation(static_cast<float>(std::atan2(v.y, v.x) * 180.0f / M_PI) - _angle.z);
-  _cannon->update();
+  _cannon->prepare();
   _cannon->setVelocity(v);
-  if (rand() % 20 == 0) {
-    _cannon->blast(4.0);
+  if (thinking) {
+    think(elapsed);
   }
-  if (rand() % 50 == 0) {
-    _cannon->defend();
+}
+
+void Boat::steer(const Vector3f &islandPos) {
+  FlowField &field = Game::getInstance().getFlowField();
+  Vector3f heading = field.isReady() ? field.direction(_coordinates) : Vector3f();
+  if (heading.x == 0.0f && heading.z == 0.0f) {
+    heading = Vector3f(islandPos.x - _coordinates.x, 0, islandPos.z - _coordinates.z).normalize();
+  }
+  heading = heading + field.separation(this, BOAT_SEPARATION_RADIUS) * BOAT_SEPARATION_WEIGHT;
+  if (heading.x != 0.0f || heading.z != 0.0f) {
+    _look = heading.normalize().invert();
   }
+}
 
-  // Check collisions
-  static auto lastCheck = -CHECK_COLLISIONS_EVERY / GAME_SPEED;
-  if (Game::getInstance().getTime() - lastCheck > CHECK_COLLISIONS_EVERY / GAME_SPEED) {
-    lastCheck = Game::getInstance().getTime();
-    for (auto entity : island->getCollidables()) {                        //Get all the subentities
-      auto aliveEntity = dynamic_cast<Alive *>(entity);                   //Can it be collided with ?
-      if (aliveEntity != nullptr) {
-        for (auto &thisShape: _shapes) {                                  //Get the shapes of the projectile
-          for (auto &enemyShape: entity->getShapes()) {                   //Get the shapes of the subentity
-            if (enemyShape.collideWith(thisShape)) {                      //Check collision
-              aliveEntity->takeDamage(getCurrentHealth() * KAMIKAZE);     //Deal damage
-              _currentHealth = 0;
-              return;
-            }
-          }
-        }
+void Boat::think(float elapsed) {
+  // Rates are expressed in real seconds, elapsed is in game time
+  std::uniform_real_distribution<float> roll(0.0f, 1.0f);
+  _wantsBlast = roll(_random) < AIScheduler::chance(BOAT_FIRE_RATE, elapsed * GAME_SPEED);
+  _wantsDefend = threatened();
+}
+
+void Boat::checkCollisions() {
+  CollisionQueue &collisions = Game::getInstance().getCollisions();
+  const Components &components = Game::getInstance().getComponents();
+  // The sphere through the hull box's corners holds it whatever the heading
+  const OrientedBox &hull = components.boxes[_handle];
+  Sphere reach{hull.center, std::sqrt(hull.half[0] * hull.half[0] + hull.half[1] * hull.half[1] +
+                                      hull.half[2] * hull.half[2])};
+  if (CollisionLayers::collides(BOAT_LAYER, ISLAND_LAYER)) {
+    for (auto entity : Game::getInstance().getCollidables(ISLAND)) {
+      auto island = dynamic_cast<Island *>(entity);
+      if (island != nullptr && island->getHeightfield().overlapsSphere(reach.center, reach.radius)) {
+        collisions.emit(CollisionEvent::CRASH, _handle, this, island, getCurrentHealth() * KAMIKAZE);
+        return;
       }
     }
-    static auto boats = std::dynamic_pointer_cast<Entities<Boat> >(Game::getInstance().getEntities().at(BOATS));
-    for (auto entity : boats->getCollidables()) {                         //Get all the subentities
-      if (entity != this) {                                               //Do not collide with yourself
-        auto aliveEntity = dynamic_cast<Alive *>(entity);                 //Can it be collided with ?
+  }
+  // Pellets, the hull's aligned box against every aligned box of their layer first, it hugs a long
+  // hull closer than the sphere does, then the hits compared as they are turned
+  if (CollisionLayers::collides(BOAT_LAYER, PLAYER_SHIELD_LAYER)) {
+    const OrientedBoxes &targets = Game::getInstance().getTargets(PLAYER_SHIELD_LAYER);
+    FrameVector<unsigned char> hits(targets.size());
+    Colliders::overlap(components.colliders[_handle], Game::getInstance().getTargetBounds(PLAYER_SHIELD_LAYER),
+                       hits.data());
+    for (size_t i = 0; i < targets.size(); ++i) {
+      if (hits[i] && Colliders::overlap(hull, targets.get(i))) {
+        auto aliveEntity = dynamic_cast<Alive *>(components.renderables[targets.ids[i]]);
         if (aliveEntity != nullptr) {
-          for (auto &thisShape: _shapes) {                                //Get the shapes of the projectile
-            for (auto &enemyShape: entity->getShapes()) {                 //Get the shapes of the subentity
-              if (enemyShape.collideWith(thisShape)) {                    //Check collision
-                aliveEntity->takeDamage(getCurrentHealth());              //Deal damage
-                _currentHealth = 0;
-                return;
-              }
-            }
-          }
+          collisions.emit(CollisionEvent::CRASH, _handle, this, aliveEntity, getCurrentHealth() * KAMIKAZE);
+          return;
         }
       }
     }
   }
+  // Only the boats bucketed around this one can touch it, hulls are compared as they are turned
+  if (!CollisionLayers::collides(BOAT_LAYER, BOAT_LAYER)) {
+    return;
+  }
+  Game::getInstance().getFlowField().forEachNeighbour(_coordinates, [this, &collisions, &components](
+      Displayable *entity, const Vector3f &) {
+    if (entity == this) {                                               //Do not collide with yourself
+      return false;
+    }
+    auto other = static_cast<Boat *>(entity);                           //The flow field only holds boats
+    if (Colliders::overlap(components.boxes[_handle], components.boxes[other->_handle])) {
+      collisions.emit(CollisionEvent::RAM, _handle, this, other, getCurrentHealth());
+      return true;
+    }
+    return false;
+  });
+}
+
+bool Boat::threatened() const {
+  // Player shells closing in from the island's side, the way they are fired from
+  static Island::Ptr island = std::dynamic_pointer_cast<Island>(Game::getInstance().getEntities().at(ISLAND));
+  Vector3f axis = island->getCoordinates() - _coordinates;
+  axis.y = 0.0f;
+  if (axis.x == 0.0f && axis.z == 0.0f) {
+    return false;
+  }
+  axis.normalize();
+  bool threat = false;
+  Game::getInstance().getSpatialIndex().forEachInCone(
+      _coordinates, axis, BOAT_THREAT_ANGLE, BOAT_THREAT_RANGE, LAYER(PLAYER_SHELL_LAYER),
+      [&](int, const Vector3f &position, const Vector3f &v) {
+        Vector3f toward = _coordinates - position;
+        threat = threat || toward.x * v.x + toward.y * v.y + toward.z * v.z > 0.0f;
+      });
+  return threat;
 }
 
 Cannon::Ptr Boat::getCannon() const {
   return _cannon;
 }
 
-const std::list<Displayable *> &Boat::getCollidables() {
-  _collidables.clear();
-  for (auto e : _cannon->getCollidables()) {
-    _collidables.push_back(e);
-  }
-  _collidables.push_back(this);
-  return _collidables;
+void Boat::getCollidables(std::vector<Displayable *> &collidables) {
+  _cannon->getCollidables(collidables);
+  collidables.push_back(this);
 }
\ No newline at end of file
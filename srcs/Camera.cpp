@@ -82,3 +82,24 @@ Vector3f Camera::getCoordinates() {
 std::pair<float, float> Camera::getRotation() {
   return std::make_pair(_xRot, _yRot);
 }
+
+Ray Camera::ray(float x, float y, float aspect) const {
+  // Undo draw()'s rotations on the eye space direction, the transpose of Rx(xRot) * Ry(yRot)
+  float scale = std::tan(CAMERA_FOV / 2.0f * (float) M_PI / 180.0f);
+  Vector3f eye(x * scale * aspect, y * scale, -1.0f);
+  float xRotRad = _xRot / 180.0f * (float) M_PI, yRotRad = _yRot / 180.0f * (float) M_PI;
+  Vector3f pitched(eye.x,
+                   eye.y * std::cos(xRotRad) + eye.z * std::sin(xRotRad),
+                   -eye.y * std::sin(xRotRad) + eye.z * std::cos(xRotRad));
+  Vector3f world(pitched.x * std::cos(yRotRad) - pitched.z * std::sin(yRotRad),
+                 pitched.y,
+                 pitched.x * std::sin(yRotRad) + pitched.z * std::cos(yRotRad));
+  return Ray{_coordinates, world};
+}
+
+Frustum Camera::frustum(float aspect) const {
+  Vector3f corners[4] = {ray(-1.0f, -1.0f, aspect).direction, ray(1.0f, -1.0f, aspect).direction,
+                         ray(1.0f, 1.0f, aspect).direction, ray(-1.0f, 1.0f, aspect).direction};
+  float focal = 1.0f / std::tan(CAMERA_FOV / 2.0f * (float) M_PI / 180.0f);
+  return Frustum(_coordinates, corners, ray(0.0f, 0.0f, aspect).direction, CAMERA_NEAR, CAMERA_FAR, focal);
+}
@@ -3,33 +3,34 @@
 //
 
 #include <iomanip>
+#include <map>
+#include <utility>
 #include "helpers/Glut.hpp"
 
 #include "includes/Cannon.hpp"
 #include "includes/Game.hpp"
+#include "includes/Lod.hpp"
+
+#define CANNON_SEGMENTS 20
 
 const float g = -9.8f;
 
-Cannon::Cannon(float speed, float radius, Color color) : _color(color),
-                                                         _speed(speed),
-                                                         _radius(radius),
-                                                         _rotation(0),
-                                                         _lastFire(-1.0f),
-                                                         _lastDefence(-5.0f) {
+/// Tube along x, ten radii long and closed at both ends
+static Triangles buildBarrel(float radius, int segments) {
   Vertices vertices;
 
   std::vector<Vertex::Ptr> top;
   std::vector<Vertex::Ptr> middle;
   std::vector<Vertex::Ptr> bottom;
   Vector3f p;
-  for (int j = 0; j < 20; j++) {
-    p.y = static_cast<float>(radius * std::cos(j * (360.0f / 20.0f) * M_PI / 180.0f));
+  for (int j = 0; j < segments; j++) {
+    p.y = static_cast<float>(radius * std::cos(j * (360.0f / segments) * M_PI / 180.0f));
     p.x = 0.0f;
-    p.z = static_cast<float>(radius * std::sin(j * (360.0f / 20.0f) * M_PI / 180.0f));
+    p.z = static_cast<float>(radius * std::sin(j * (360.0f / segments) * M_PI / 180.0f));
     bottom.push_back(std::make_shared<Vertex>(p));
-    p.x = _radius * 5.0f;
+    p.x = radius * 5.0f;
     middle.push_back(std::make_shared<Vertex>(p));
-    p.x = _radius * 10.0f;
+    p.x = radius * 10.0f;
     top.push_back(std::make_shared<Vertex>(p));
   }
   vertices.push_back(bottom);
@@ -38,7 +39,7 @@ Cannon::Cannon(float speed, float radius, Color color) : _color(color),
 
   Triangles triangles;
   Vertex::Ptr centerBottom = std::make_shared<Vertex>(Vector3f(0.0f, 0.0f, 0.0f));
-  Vertex::Ptr centerTop = std::make_shared<Vertex>(Vector3f(_radius * 10.0f, 0.0f, 0.0f));
+  Vertex::Ptr centerTop = std::make_shared<Vertex>(Vector3f(radius * 10.0f, 0.0f, 0.0f));
   Vertex::Ptr bl = vertices[0][vertices[0].size() - 1];
   Vertex::Ptr br = vertices[0][0];
   Vertex::Ptr ml = vertices[1][vertices[1].size() - 1];
@@ -65,13 +66,43 @@ Cannon::Cannon(float speed, float radius, Color color) : _color(color),
     triangles.emplace_back(br, centerBottom, bl, Triangle::computeNormal(br->p, centerBottom->p, bl->p));
     triangles.emplace_back(tl, centerTop, tr, Triangle::computeNormal(tl->p, centerTop->p, tr->p));
   }
-  Shape shape = Shape(triangles, GL_TRIANGLES, color);
+  Shape shape = Shape(std::move(triangles));
   shape.computePerVertexNormal();
-  _shapes.push_back(shape);
+  return std::move(shape._parts);
+}
+
+/// Every cannon of a size shares the same vertices, only the triangle array is copied per cannon
+static Shape barrel(float radius, int segments, Color color) {
+  // Cannons are built with their boat in the serial phase, so the cache needs no lock
+  static std::map<std::pair<float, int>, Triangles> barrels;
+  auto found = barrels.find(std::make_pair(radius, segments));
+  if (found == barrels.end()) {
+    found = barrels.emplace(std::make_pair(radius, segments), buildBarrel(radius, segments)).first;
+  }
+  return Shape(found->second, GL_TRIANGLES, color);
+}
+
+Cannon::Cannon(float speed, float radius, Color color, CollisionLayer shells, CollisionLayer shields)
+    : _color(color),
+      _shells(shells),
+      _shields(shields),
+      _speed(speed),
+      _radius(radius),
+      _rotation(0),
+      _lastFire(-1.0f),
+      _lastDefence(-5.0f),
+      _projectiles(PROJECTILE_POOL_SIZE),
+      _defences(PELLET_POOL_SIZE),
+      _lod(0) {
+  _shapes.push_back(barrel(radius, Lod::segments(CANNON_SEGMENTS, 0), color));
+  for (int level = 1; level < LOD_LEVELS; ++level) {
+    _levels.emplace_back();
+    _levels.back().push_back(barrel(radius, Lod::segments(CANNON_SEGMENTS, level), color));
+  }
 }
 
 void Cannon::drawTrajectory() const {
-  glEnable(GL_BLEND);
+  GlState::enable(GL_BLEND);
   glPushMatrix();
 
   GLfloat rotation1[16], rotation2[16], translation[16], first[16], final[16];
@@ -97,19 +128,34 @@ void Cannon::drawTrajectory() const {
     }
 
     glVertex3f(x, y, z);
-    t += 0.01;
+    t += TRAJECTORY_STEP;
   }
   glEnd();
   glPopMatrix();
-  glDisable(GL_BLEND);
+  GlState::disable(GL_BLEND);
 }
 
 void Cannon::draw() const {
+  // Shells and pellets cull themselves, they fly out of view independently of the barrel
+  const Frustum &frustum = Game::getInstance().getFrustum();
+  if (GlState::visible(frustum.sphere(_coordinates, _radius * 12.0f))) {
+    // The ball at the breech is the widest part
+    _lod = GlState::lod(Lod::select(frustum.screenSize(_coordinates, _radius * 2.0f), 2.0f * M_PI, CANNON_SEGMENTS,
+                                    _lod));
+    drawBarrel();
+  }
+  drawTrajectory();
+
+  _projectiles.draw();
+  _defences.draw();
+}
+
+void Cannon::drawBarrel() const {
   if (Game::getInstance().getShowLight()) {
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_COLOR_MATERIAL);
-    glEnable(GL_NORMALIZE);
+    GlState::enable(GL_LIGHTING);
+    GlState::enable(GL_LIGHT0);
+    GlState::enable(GL_COLOR_MATERIAL);
+    GlState::enable(GL_NORMALIZE);
 
     GLfloat specular[] = {0.5f, 0.5f, 0.5f, 1.0f};
     glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
@@ -121,7 +167,7 @@ void Cannon::draw() const {
     glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
   }
 
-  glEnable(GL_BLEND);
+  GlState::enable(GL_BLEND);
   glPushMatrix();
 
   GLfloat m[16];
@@ -129,24 +175,20 @@ void Cannon::draw() const {
   glMultMatrixf((_angle * (M_PI / 180.0f)).toRotationMatrix(m));
   glMultMatrixf((Vector3f{0.0f, 0.0f, _rotation} * (M_PI / 180.0f)).toRotationMatrix(m));
 
-  Displayable::draw();
+  drawShapes(_lod == 0 ? _shapes : _levels[_lod - 1]);
   _shapes.front().applyColor();
-  glutSolidSphere(_radius * 2.0f, 20, 20);
+  int slices = Lod::segments(SPHERE_SLICES, _lod);
+  glutSolidSphere(_radius * 2.0f, slices, slices);
 
   glPopMatrix();
-  glDisable(GL_BLEND);
+  GlState::disable(GL_BLEND);
 
   if (Game::getInstance().getShowLight()) {
-    glDisable(GL_NORMALIZE);
-    glDisable(GL_COLOR_MATERIAL);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_LIGHTING);
+    GlState::disable(GL_NORMALIZE);
+    GlState::disable(GL_COLOR_MATERIAL);
+    GlState::disable(GL_LIGHT0);
+    GlState::disable(GL_LIGHTING);
   }
-
-  drawTrajectory();
-
-  _projectiles.draw();
-  _defences.draw();
 }
 
 void Cannon::blast(float handicap) {
@@ -159,7 +201,7 @@ void Cannon::blast(float handicap) {
     Vector3f::multMatrix(translation, rotation1, first);
     Vector3f::multMatrix(first, rotation2, final);
     Vector3f c = Vector3f(_radius * 12.0f, 0.0f, 0.0f) * final;
-    _projectiles.add(std::make_shared<Projectile>(Game::getInstance().getTime(), c, _velocity, _color));
+    _projectiles.spawn(Game::getInstance().getTime(), c, _velocity, _shells, _color);
   }
 }
 
@@ -173,7 +215,7 @@ void Cannon::defend() {
     Vector3f::multMatrix(translation, rotation1, first);
     Vector3f::multMatrix(first, rotation2, final);
     Vector3f c = Vector3f(_radius * 12.0f, 0.0f, 0.0f) * final;
-    _defences.add(std::make_shared<Pellet>(Game::getInstance().getTime(), c, _angle, _rotation, _color));
+    _defences.spawn(Game::getInstance().getTime(), c, _angle, _rotation, _shields, _color);
   }
 }
 
@@ -210,7 +252,27 @@ void Cannon::setAngle(Vector3f angle) {
   _angle = angle;
 }
 
-void Cannon::update() {
+bool Cannon::aimAt(const Vector3f &target) {
+  // Solved from the pivot first, then again from where the muzzle ends up
+  bool reachable = false;
+  Vector3f muzzle = _coordinates;
+  for (int pass = 0; pass < 2; ++pass) {
+    float dx = target.x - muzzle.x, dy = target.y - muzzle.y, dz = target.z - muzzle.z;
+    float distance = std::hypot(dx, dz);
+    float s2 = _speed * _speed;
+    float root = s2 * s2 - g * (g * distance * distance - 2.0f * dy * s2);
+    reachable = root >= 0.0f && distance > 0.0f;
+    float elevation = distance == 0.0f ? 90.0f
+                      : root < 0.0f ? 45.0f
+                      : static_cast<float>(std::atan2(s2 - std::sqrt(root), -g * distance) * 180.0f / M_PI);
+    _angle = {0.0f, static_cast<float>(std::atan2(-dz, dx) * 180.0f / M_PI), 0.0f};
+    setRotation(elevation);
+    muzzle = _coordinates + Orientation::fromAngles(_angle, _rotation).axes[0] * (_radius * 12.0f);
+  }
+  return reachable;
+}
+
+void Cannon::prepare() {
   GLfloat rotation1[16], rotation2[16], translation[16], first[16], final[16];
   _coordinates.toTranslationMatrix(translation);
   (_angle * (M_PI / 180.0f)).toRotationMatrix(rotation1);
@@ -222,16 +284,18 @@ void Cannon::update() {
   _velocity = (tip - base);
   _velocity.normalize();
   _velocity = _velocity * _speed;
+}
 
+void Cannon::detect() {
+  _projectiles.detect();
+}
+
+void Cannon::update() {
   _projectiles.update();
   _defences.update();
 }
 
-const std::list<Displayable *> &Cannon::getCollidables() {
-  _collidables.clear();
-  for (auto e : _defences.getCollidables()) {
-    _collidables.push_back(e);
-  }
-  _collidables.push_back(this);
-  return _collidables;
+void Cannon::getCollidables(std::vector<Displayable *> &collidables) {
+  _defences.getCollidables(collidables);
+  collidables.push_back(this);
 }
\ No newline at end of file
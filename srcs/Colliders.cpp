@@ -0,0 +1,290 @@
+//
+//  Colliders.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "includes/Colliders.hpp"
+
+static float dot(const Vector3f &a, const Vector3f &b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+/// Parallel edges give near zero cross products, this keeps their SAT test from failing on rounding
+#define SAT_EPSILON 1e-6f
+
+Orientation::Orientation() : axes{Vector3f(1.0f, 0.0f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f), Vector3f(0.0f, 0.0f, 1.0f)} {}
+
+Orientation Orientation::fromAngles(const Vector3f &angle, float rotation) {
+  GLfloat first[16], second[16], m[16];
+  (angle * (M_PI / 180.0f)).toRotationMatrix(first);
+  (Vector3f{0.0f, 0.0f, rotation} * (M_PI / 180.0f)).toRotationMatrix(second);
+  Vector3f::multMatrix(first, second, m);
+
+  Orientation orientation;
+  for (int k = 0; k < 3; ++k) {
+    orientation.axes[k] = Vector3f(m[4 * k], m[4 * k + 1], m[4 * k + 2]);
+  }
+  return orientation;
+}
+
+OrientedBox::OrientedBox() : axes{Vector3f(1.0f, 0.0f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f), Vector3f(0.0f, 0.0f, 1.0f)},
+                             half{0.0f, 0.0f, 0.0f} {}
+
+OrientedBox::OrientedBox(const BoundingBox &local, const Vector3f &position, const Orientation &orientation) {
+  Vector3f middle = (local.vecMin + local.vecMax) * 0.5f;
+  center = position + orientation.axes[0] * middle.x + orientation.axes[1] * middle.y + orientation.axes[2] * middle.z;
+  for (int k = 0; k < 3; ++k) {
+    axes[k] = orientation.axes[k];
+  }
+  half[0] = (local.vecMax.x - local.vecMin.x) * 0.5f;
+  half[1] = (local.vecMax.y - local.vecMin.y) * 0.5f;
+  half[2] = (local.vecMax.z - local.vecMin.z) * 0.5f;
+}
+
+BoundingBox OrientedBox::bounds() const {
+  Vector3f extent;
+  for (int k = 0; k < 3; ++k) {
+    extent.x += std::fabs(axes[k].x) * half[k];
+    extent.y += std::fabs(axes[k].y) * half[k];
+    extent.z += std::fabs(axes[k].z) * half[k];
+  }
+  return BoundingBox(center - extent, center + extent);
+}
+
+void OrientedBoxes::clear() {
+  for (std::vector<float> &field : fields) {
+    field.clear();
+  }
+  ids.clear();
+}
+
+void OrientedBoxes::push(const OrientedBox &box, int id) {
+  const float values[FIELD_EOF] = {
+      box.center.x, box.center.y, box.center.z,
+      box.axes[0].x, box.axes[0].y, box.axes[0].z,
+      box.axes[1].x, box.axes[1].y, box.axes[1].z,
+      box.axes[2].x, box.axes[2].y, box.axes[2].z,
+      box.half[0], box.half[1], box.half[2],
+  };
+  for (int f = 0; f < FIELD_EOF; ++f) {
+    fields[f].push_back(values[f]);
+  }
+  ids.push_back(id);
+}
+
+size_t OrientedBoxes::size() const {
+  return ids.size();
+}
+
+OrientedBox OrientedBoxes::get(size_t i) const {
+  OrientedBox box;
+  box.center = Vector3f(fields[CX][i], fields[CY][i], fields[CZ][i]);
+  box.axes[0] = Vector3f(fields[UX][i], fields[UY][i], fields[UZ][i]);
+  box.axes[1] = Vector3f(fields[VX][i], fields[VY][i], fields[VZ][i]);
+  box.axes[2] = Vector3f(fields[WX][i], fields[WY][i], fields[WZ][i]);
+  box.half[0] = fields[HU][i];
+  box.half[1] = fields[HV][i];
+  box.half[2] = fields[HW][i];
+  return box;
+}
+
+void AlignedBoxes::clear() {
+  for (std::vector<float> &field : fields) {
+    field.clear();
+  }
+  ids.clear();
+}
+
+void AlignedBoxes::push(const BoundingBox &box, int id) {
+  fields[MIN_X].push_back(box.vecMin.x);
+  fields[MIN_Y].push_back(box.vecMin.y);
+  fields[MIN_Z].push_back(box.vecMin.z);
+  fields[MAX_X].push_back(box.vecMax.x);
+  fields[MAX_Y].push_back(box.vecMax.y);
+  fields[MAX_Z].push_back(box.vecMax.z);
+  ids.push_back(id);
+}
+
+size_t AlignedBoxes::size() const {
+  return ids.size();
+}
+
+bool Colliders::overlap(const OrientedBox &a, const OrientedBox &b) {
+  // b's axes and the distance between centers, expressed in a's frame
+  float r[3][3], absR[3][3];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      r[i][j] = dot(a.axes[i], b.axes[j]);
+      absR[i][j] = std::fabs(r[i][j]) + SAT_EPSILON;
+    }
+  }
+  Vector3f d = b.center - a.center;
+  float t[3] = {dot(d, a.axes[0]), dot(d, a.axes[1]), dot(d, a.axes[2])};
+
+  // a's faces
+  for (int i = 0; i < 3; ++i) {
+    if (std::fabs(t[i]) > a.half[i] + b.half[0] * absR[i][0] + b.half[1] * absR[i][1] + b.half[2] * absR[i][2]) {
+      return false;
+    }
+  }
+  // b's faces
+  for (int j = 0; j < 3; ++j) {
+    float projected = t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j];
+    if (std::fabs(projected) > a.half[0] * absR[0][j] + a.half[1] * absR[1][j] + a.half[2] * absR[2][j] + b.half[j]) {
+      return false;
+    }
+  }
+  // Edge pairs, a's axis i crossed with b's axis j
+  for (int i = 0; i < 3; ++i) {
+    int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+    for (int j = 0; j < 3; ++j) {
+      int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+      float ra = a.half[i1] * absR[i2][j] + a.half[i2] * absR[i1][j];
+      float rb = b.half[j1] * absR[i][j2] + b.half[j2] * absR[i][j1];
+      if (std::fabs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool Colliders::overlap(const OrientedBox &box, const Sphere &sphere) {
+  Vector3f d = sphere.center - box.center;
+  float distance = 0.0f;
+  for (int k = 0; k < 3; ++k) {
+    float excess = std::max(std::fabs(dot(d, box.axes[k])) - box.half[k], 0.0f);
+    distance += excess * excess;
+  }
+  return distance <= sphere.radius * sphere.radius;
+}
+
+bool Colliders::overlap(const OrientedBox &box, const Capsule &capsule) {
+  // Slab test of the segment against the box grown by the radius, in the box's frame
+  Vector3f from = capsule.from - box.center;
+  Vector3f delta = capsule.to - capsule.from;
+  float t0 = 0.0f, t1 = 1.0f;
+  for (int k = 0; k < 3; ++k) {
+    float p = dot(from, box.axes[k]), d = dot(delta, box.axes[k]);
+    float extent = box.half[k] + capsule.radius;
+    if (std::fabs(d) < SAT_EPSILON) {
+      if (std::fabs(p) > extent) {
+        return false;
+      }
+      continue;
+    }
+    float ta = (-extent - p) / d, tb = (extent - p) / d;
+    t0 = std::max(t0, std::min(ta, tb));
+    t1 = std::min(t1, std::max(ta, tb));
+    if (t0 > t1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Colliders::intersect(const Ray &ray, const OrientedBox &box, float &t) {
+  // Same slab test, the ray is only bounded on one side
+  Vector3f from = ray.origin - box.center;
+  float t0 = 0.0f, t1 = std::numeric_limits<float>::max();
+  for (int k = 0; k < 3; ++k) {
+    float p = dot(from, box.axes[k]), d = dot(ray.direction, box.axes[k]);
+    if (std::fabs(d) < SAT_EPSILON) {
+      if (std::fabs(p) > box.half[k]) {
+        return false;
+      }
+      continue;
+    }
+    float ta = (-box.half[k] - p) / d, tb = (box.half[k] - p) / d;
+    t0 = std::max(t0, std::min(ta, tb));
+    t1 = std::min(t1, std::max(ta, tb));
+    if (t0 > t1) {
+      return false;
+    }
+  }
+  t = t0;
+  return true;
+}
+
+bool Colliders::overlap(const Sphere &a, const Sphere &b) {
+  Vector3f d = b.center - a.center;
+  float reach = a.radius + b.radius;
+  return dot(d, d) <= reach * reach;
+}
+
+bool Colliders::overlap(const Capsule &capsule, const Sphere &sphere) {
+  Vector3f delta = capsule.to - capsule.from;
+  float length = dot(delta, delta);
+  float t = length > 0.0f ? std::max(0.0f, std::min(dot(sphere.center - capsule.from, delta) / length, 1.0f)) : 0.0f;
+  return overlap(Sphere{capsule.from + delta * t, capsule.radius}, sphere);
+}
+
+void Colliders::overlap(const Sphere &sphere, const OrientedBoxes &boxes, unsigned char *hits) {
+  const std::vector<float> *f = boxes.fields;
+  size_t count = boxes.size(), i = 0;
+
+#if defined(__SSE2__)
+  const __m128 sx = _mm_set1_ps(sphere.center.x), sy = _mm_set1_ps(sphere.center.y), sz = _mm_set1_ps(sphere.center.z);
+  const __m128 radius2 = _mm_set1_ps(sphere.radius * sphere.radius);
+  const __m128 sign = _mm_set1_ps(-0.0f), zero = _mm_setzero_ps();
+  for (; i + 4 <= count; i += 4) {
+    __m128 dx = _mm_sub_ps(sx, _mm_loadu_ps(&f[OrientedBoxes::CX][i]));
+    __m128 dy = _mm_sub_ps(sy, _mm_loadu_ps(&f[OrientedBoxes::CY][i]));
+    __m128 dz = _mm_sub_ps(sz, _mm_loadu_ps(&f[OrientedBoxes::CZ][i]));
+    __m128 distance = zero;
+    for (int k = 0; k < 3; ++k) {
+      __m128 projected = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&f[OrientedBoxes::UX + 3 * k][i])),
+                                               _mm_mul_ps(dy, _mm_loadu_ps(&f[OrientedBoxes::UY + 3 * k][i]))),
+                                    _mm_mul_ps(dz, _mm_loadu_ps(&f[OrientedBoxes::UZ + 3 * k][i])));
+      __m128 excess = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, projected), _mm_loadu_ps(&f[OrientedBoxes::HU + k][i])),
+                                 zero);
+      distance = _mm_add_ps(distance, _mm_mul_ps(excess, excess));
+    }
+    int mask = _mm_movemask_ps(_mm_cmple_ps(distance, radius2));
+    for (int lane = 0; lane < 4; ++lane) {
+      hits[i + lane] = static_cast<unsigned char>((mask >> lane) & 1);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    hits[i] = static_cast<unsigned char>(overlap(boxes.get(i), sphere));
+  }
+}
+
+void Colliders::overlap(const BoundingBox &box, const AlignedBoxes &boxes, unsigned char *hits) {
+  const std::vector<float> *f = boxes.fields;
+  size_t count = boxes.size(), i = 0;
+
+#if defined(__SSE2__)
+  const __m128 minX = _mm_set1_ps(box.vecMin.x), minY = _mm_set1_ps(box.vecMin.y), minZ = _mm_set1_ps(box.vecMin.z);
+  const __m128 maxX = _mm_set1_ps(box.vecMax.x), maxY = _mm_set1_ps(box.vecMax.y), maxZ = _mm_set1_ps(box.vecMax.z);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_and_ps(_mm_cmplt_ps(minX, _mm_loadu_ps(&f[AlignedBoxes::MAX_X][i])),
+                          _mm_cmpgt_ps(maxX, _mm_loadu_ps(&f[AlignedBoxes::MIN_X][i])));
+    __m128 y = _mm_and_ps(_mm_cmplt_ps(minY, _mm_loadu_ps(&f[AlignedBoxes::MAX_Y][i])),
+                          _mm_cmpgt_ps(maxY, _mm_loadu_ps(&f[AlignedBoxes::MIN_Y][i])));
+    __m128 z = _mm_and_ps(_mm_cmplt_ps(minZ, _mm_loadu_ps(&f[AlignedBoxes::MAX_Z][i])),
+                          _mm_cmpgt_ps(maxZ, _mm_loadu_ps(&f[AlignedBoxes::MIN_Z][i])));
+    int mask = _mm_movemask_ps(_mm_and_ps(_mm_and_ps(x, y), z));
+    for (int lane = 0; lane < 4; ++lane) {
+      hits[i + lane] = static_cast<unsigned char>((mask >> lane) & 1);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    hits[i] = static_cast<unsigned char>(box.vecMin.x < f[AlignedBoxes::MAX_X][i] &&
+                                         box.vecMax.x > f[AlignedBoxes::MIN_X][i] &&
+                                         box.vecMin.y < f[AlignedBoxes::MAX_Y][i] &&
+                                         box.vecMax.y > f[AlignedBoxes::MIN_Y][i] &&
+                                         box.vecMin.z < f[AlignedBoxes::MAX_Z][i] &&
+                                         box.vecMax.z > f[AlignedBoxes::MIN_Z][i]);
+  }
+}
@@ -0,0 +1,63 @@
+//
+//  Collisions.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+
+#include "includes/Collisions.hpp"
+#include "includes/JobSystem.hpp"
+
+static const unsigned MASKS[COLLISION_LAYERS_EOF] = {
+    PLAYER_SHELL_MASK, ENEMY_SHELL_MASK, BOAT_MASK, ISLAND_MASK, PLAYER_SHIELD_MASK, ENEMY_SHIELD_MASK
+};
+
+unsigned CollisionLayers::mask(CollisionLayer layer) {
+  return MASKS[layer];
+}
+
+bool CollisionLayers::collides(CollisionLayer a, CollisionLayer b) {
+  return (MASKS[a] & LAYER(b)) != 0 && (MASKS[b] & LAYER(a)) != 0;
+}
+
+CollisionQueue::CollisionQueue() : _buffers(JobSystem::getInstance().threads()), _counts() {}
+
+void CollisionQueue::emit(CollisionEvent::Type type, int key, Alive *source, Alive *target, int damage) {
+  _buffers[JobSystem::currentThread()].push_back({type, key, source, target, damage});
+}
+
+int CollisionQueue::resolve() {
+  _merged.clear();
+  for (auto &buffer : _buffers) {
+    _merged.insert(_merged.end(), buffer.begin(), buffer.end());
+    buffer.clear();
+  }
+  std::sort(_merged.begin(), _merged.end(), [](const CollisionEvent &lhs, const CollisionEvent &rhs) {
+    return lhs.key != rhs.key ? lhs.key < rhs.key : lhs.type < rhs.type;
+  });
+
+  std::fill(_counts, _counts + CollisionEvent::TYPE_EOF, 0);
+  int applied = 0;
+  for (const CollisionEvent &event : _merged) {
+    if (event.source->getCurrentHealth() == 0) {
+      continue;
+    }
+    event.target->takeDamage(event.damage);
+    event.source->kill();
+    ++_counts[event.type];
+    ++applied;
+  }
+  return applied;
+}
+
+int CollisionQueue::getCount(CollisionEvent::Type type) const {
+  return _counts[type];
+}
+
+int CollisionQueue::getTotal() const {
+  int total = 0;
+  for (int count : _counts) {
+    total += count;
+  }
+  return total;
+}
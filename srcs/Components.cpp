@@ -0,0 +1,113 @@
+//
+//  Components.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+
+#include "includes/Components.hpp"
+#include "includes/Waves.hpp"
+
+extern const float g;
+
+Components::Handle Components::create(Displayable *owner, CollisionLayer layer, unsigned char flags) {
+  Handle handle;
+  if (!_free.empty()) {
+    handle = _free.back();
+    _free.pop_back();
+  } else {
+    handle = static_cast<Handle>(this->flags.size());
+    positions.emplace_back();
+    velocities.emplace_back();
+    origins.emplace_back();
+    spawnTimes.emplace_back(0.0f);
+    bounds.emplace_back();
+    orientations.emplace_back();
+    boxes.emplace_back();
+    colliders.emplace_back();
+    renderables.emplace_back(nullptr);
+    layers.emplace_back(BOAT_LAYER);
+    this->flags.emplace_back(NONE);
+  }
+
+  positions[handle] = owner->getCoordinates();
+  velocities[handle] = Vector3f();
+  origins[handle] = positions[handle];
+  spawnTimes[handle] = 0.0f;
+  bounds[handle] = BoundingBox();
+  orientations[handle] = Orientation();
+  boxes[handle] = OrientedBox(bounds[handle], positions[handle], orientations[handle]);
+  colliders[handle] = BoundingBox(positions[handle], positions[handle]);
+  renderables[handle] = owner;
+  layers[handle] = layer;
+  this->flags[handle] = static_cast<unsigned char>(flags | ALIVE);
+  return handle;
+}
+
+void Components::destroy(Handle handle) {
+  if (handle < 0 || handle >= flags.size() || !(flags[handle] & ALIVE)) {
+    return;
+  }
+  flags[handle] = NONE;
+  renderables[handle] = nullptr;
+  _free.push_back(handle);
+}
+
+size_t Components::size() const {
+  return flags.size();
+}
+
+size_t Components::count() const {
+  return flags.size() - _free.size();
+}
+
+size_t Components::count(unsigned char flags) const {
+  flags |= ALIVE;
+  return static_cast<size_t>(std::count_if(this->flags.begin(), this->flags.end(), [flags](unsigned char f) {
+    return (f & flags) == flags;
+  }));
+}
+
+void Systems::ballistics(Components &components, float time, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    if ((components.flags[i] & (Components::ALIVE | Components::BALLISTIC)) !=
+        (Components::ALIVE | Components::BALLISTIC)) {
+      continue;
+    }
+    const Vector3f &o = components.origins[i];
+    const Vector3f &v = components.velocities[i];
+    float t = time - components.spawnTimes[i];
+    Vector3f &p = components.positions[i];
+    p.x = o.x + v.x * t;
+    p.y = o.y + v.y * t + g * t * t / 2.0f;
+    p.z = o.z + v.z * t;
+
+    if (p.y < Waves::computeHeight(p.x, p.z) || p.y > 1 || p.x < -1 || p.x > 1 || p.z < -1 || p.z > 1) {
+      components.flags[i] |= Components::EXPIRED;
+    }
+  }
+}
+
+void Systems::colliders(Components &components, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    if (!(components.flags[i] & Components::ALIVE)) {
+      continue;
+    }
+    components.boxes[i] = OrientedBox(components.bounds[i], components.positions[i], components.orientations[i]);
+    components.colliders[i] = components.boxes[i].bounds();
+  }
+}
+
+void Systems::targets(const Components &components, std::array<OrientedBoxes, COLLISION_LAYERS_EOF> &targets,
+                      std::array<AlignedBoxes, COLLISION_LAYERS_EOF> &bounds) {
+  for (int layer = 0; layer < COLLISION_LAYERS_EOF; ++layer) {
+    targets[layer].clear();
+    bounds[layer].clear();
+  }
+  for (size_t i = 0; i < components.size(); ++i) {
+    if ((components.flags[i] & (Components::ALIVE | Components::BALLISTIC)) == Components::ALIVE) {
+      targets[components.layers[i]].push(components.boxes[i], static_cast<int>(i));
+      bounds[components.layers[i]].push(components.colliders[i], static_cast<int>(i));
+    }
+  }
+}
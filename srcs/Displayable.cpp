@@ -2,32 +2,86 @@
 // Created by wilmot_g on 02/04/18.
 //
 
+#include <algorithm>
+#include <cstdio>
+
 #include "includes/Shape.hpp"
 #include "includes/Game.hpp"
 
+/// What the fixed-function pipeline makes of `color` at `v`, without the specular highlight
+static Color shade(const Color &color, const Vertex &v, const Vector3f &light) {
+  Vector3f l = light - v.p;
+  l.normalize();
+  float diffuse = std::max(0.0f, v.n.x * l.x + v.n.y * l.y + v.n.z * l.z);
+  float k = std::min(LIGHT_AMBIENT + LIGHT_DIFFUSE * diffuse, 1.0f);
+  return Color(color.r * k, color.g * k, color.b * k, color.a);
+}
+
+static void emit(const Shape &shape, const Vector3f *light) {
+  glBegin(shape._mode);
+  shape.applyColor();
+  for (const Triangle &t : shape._parts) {
+    for (const Vertex *v : {t.v1.get(), t.v2.get(), t.v3.get()}) {
+      if (light) {
+        Color c = shade(shape._color, *v, *light);
+        glColor4f(c.r, c.g, c.b, c.a);
+      }
+      glNormal3f(v->n.x, v->n.y, v->n.z);
+      glVertex3f(v->p.x, v->p.y, v->p.z);
+    }
+  }
+  glEnd();
+}
+
 void Displayable::draw() const {
-  for (Shape shape: _shapes) {
-    glBegin(shape._mode);
-    shape.applyColor();
-    for (Triangle &t : shape._parts) {
-      glNormal3f(t.v1->n.x, t.v1->n.y, t.v1->n.z);
-      glVertex3f(t.v1->p.x, t.v1->p.y, t.v1->p.z);
-      glNormal3f(t.v2->n.x, t.v2->n.y, t.v2->n.z);
-      glVertex3f(t.v2->p.x, t.v2->p.y, t.v2->p.z);
-      glNormal3f(t.v3->n.x, t.v3->n.y, t.v3->n.z);
-      glVertex3f(t.v3->p.x, t.v3->p.y, t.v3->p.z);
+  drawShapes(_shapes);
+}
+
+bool Displayable::compile(Shapes &shapes, const Vector3f *light) {
+  for (Shape &shape : shapes) {
+    GLuint list = glGenLists(light ? 2 : 1);
+    if (!list) {
+      fprintf(stderr, "displayable: no display list left, drawing vertex by vertex\n");
+      return false;
+    }
+    shape._list = list;
+    glNewList(shape._list, GL_COMPILE);
+    emit(shape, nullptr);
+    glEndList();
+    if (light) {
+      shape._litList = list + 1;
+      glNewList(shape._litList, GL_COMPILE);
+      emit(shape, light);
+      glEndList();
+    }
+  }
+  return true;
+}
+
+void Displayable::drawShapes(const Shapes &shapes, bool lit) const {
+  const Frustum &frustum = Game::getInstance().getFrustum();
+  for (const Shape &shape: shapes) {
+    if (_worldSpace && !GlState::visible(frustum.box(shape.get_boundingBox()))) {
+      continue;
+    }
+    GlState::submitted(shape._parts.size());
+    if (lit && shape._litList) {
+      glCallList(shape._litList);
+    } else if (shape._list) {
+      glCallList(shape._list);
+    } else {
+      emit(shape, nullptr);
     }
-    glEnd();
   }
 
   if (Game::getInstance().getShowNormal()) {
     glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
-    glDisable(GL_COLOR_MATERIAL);
-    glDisable(GL_BLEND);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_LIGHTING);
+    GlState::disable(GL_COLOR_MATERIAL);
+    GlState::disable(GL_BLEND);
+    GlState::disable(GL_LIGHT0);
+    GlState::disable(GL_LIGHTING);
     glBegin(GL_LINES);
-    for (const Shape &row : _shapes) {
+    for (const Shape &row : shapes) {
       for (const Triangle &t : row._parts) {
         glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
         Axes::drawVector(t.v1->p, t.v1->n, 0.1f, true);
@@ -47,6 +101,4 @@ bool Displayable::isDisplayed() const {
   return _isDisplayed;
 }
 
-const std::list<Displayable *> &Displayable::getCollidables() {
-  return _collidables;
-}
+void Displayable::getCollidables(std::vector<Displayable *> &) {}
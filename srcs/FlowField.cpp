@@ -0,0 +1,178 @@
+//
+//  FlowField.cpp
+//  IslandDefense3D
+//
+
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <functional>
+
+#include "includes/FlowField.hpp"
+
+FlowField::FlowField(int resolution, float extent) : _resolution(resolution),
+                                                     _extent(extent),
+                                                     _cellSize(2.0f * extent / resolution),
+                                                     _ready(false) {
+  _buckets = std::max(1, static_cast<int>(std::ceil(2.0f * extent / BOAT_SEPARATION_RADIUS)));
+  _bucketSize = 2.0f * extent / _buckets;
+  _occupants.resize(static_cast<size_t>(_buckets * _buckets));
+}
+
+FlowField::~FlowField() {
+  if (_worker.joinable()) {
+    _worker.join();
+  }
+}
+
+void FlowField::build(const BoundingBox &goal, const std::vector<BoundingBox> &obstacles) {
+  const int n = _resolution;
+  const float infinity = std::numeric_limits<float>::max();
+  std::vector<float> cost(static_cast<size_t>(n * n), infinity);
+  std::vector<bool> blocked(static_cast<size_t>(n * n), false);
+
+  typedef std::pair<float, int> Node;
+  std::priority_queue<Node, std::vector<Node>, std::greater<Node> > open;
+
+  auto inside = [](const BoundingBox &box, float x, float z) {
+    return x >= box.vecMin.x && x <= box.vecMax.x && z >= box.vecMin.z && z <= box.vecMax.z;
+  };
+
+  for (int z = 0; z < n; ++z) {
+    for (int x = 0; x < n; ++x) {
+      int i = z * n + x;
+      for (const BoundingBox &obstacle : obstacles) {
+        blocked[i] = blocked[i] || inside(obstacle, center(x), center(z));
+      }
+      if (inside(goal, center(x), center(z))) {
+        cost[i] = 0.0f;
+        open.push(Node(0.0f, i));
+      }
+    }
+  }
+
+  // Dijkstra from the goal cells, 8-connected
+  static const int offsets[8][2] = {{1,  0}, {-1, 0}, {0,  1}, {0,  -1},
+                                    {1,  1}, {1,  -1}, {-1, 1}, {-1, -1}};
+  while (!open.empty()) {
+    Node node = open.top();
+    open.pop();
+    if (node.first > cost[node.second]) {
+      continue;
+    }
+    int x = node.second % n;
+    int z = node.second / n;
+    for (auto &offset : offsets) {
+      int nx = x + offset[0];
+      int nz = z + offset[1];
+      if (nx < 0 || nz < 0 || nx >= n || nz >= n || blocked[nz * n + nx]) {
+        continue;
+      }
+      float step = offset[0] != 0 && offset[1] != 0 ? static_cast<float>(M_SQRT2) : 1.0f;
+      if (node.first + step < cost[nz * n + nx]) {
+        cost[nz * n + nx] = node.first + step;
+        open.push(Node(node.first + step, nz * n + nx));
+      }
+    }
+  }
+
+  // Each cell points at its cheapest neighbour, goal cells point at the goal center
+  std::vector<float> dx(static_cast<size_t>(n * n), 0.0f), dz(static_cast<size_t>(n * n), 0.0f);
+  float goalX = (goal.vecMin.x + goal.vecMax.x) / 2.0f;
+  float goalZ = (goal.vecMin.z + goal.vecMax.z) / 2.0f;
+  for (int z = 0; z < n; ++z) {
+    for (int x = 0; x < n; ++x) {
+      int i = z * n + x;
+      float best = cost[i];
+      int bestX = x, bestZ = z;
+      for (auto &offset : offsets) {
+        int nx = x + offset[0];
+        int nz = z + offset[1];
+        if (nx >= 0 && nz >= 0 && nx < n && nz < n && cost[nz * n + nx] < best) {
+          best = cost[nz * n + nx];
+          bestX = nx;
+          bestZ = nz;
+        }
+      }
+      Vector3f d = cost[i] == 0.0f ? Vector3f(goalX - center(x), 0.0f, goalZ - center(z))
+                                   : Vector3f(bestX - x, 0.0f, bestZ - z);
+      if (d.x != 0.0f || d.z != 0.0f) {
+        d.normalize();
+        dx[i] = d.x;
+        dz[i] = d.z;
+      }
+    }
+  }
+
+  _dx.swap(dx);
+  _dz.swap(dz);
+  _ready = true;
+}
+
+void FlowField::buildAsync(const BoundingBox &goal, const std::vector<BoundingBox> &obstacles) {
+  if (_worker.joinable()) {
+    _worker.join();
+  }
+  _ready = false;
+  _worker = std::thread([this, goal, obstacles]() { build(goal, obstacles); });
+}
+
+bool FlowField::isReady() const {
+  return _ready;
+}
+
+Vector3f FlowField::direction(const Vector3f &position) const {
+  // Bilinear blend of the four surrounding cell centers
+  float fx = (position.x + _extent) / _cellSize - 0.5f;
+  float fz = (position.z + _extent) / _cellSize - 0.5f;
+  int x0 = std::max(0, std::min(_resolution - 2, static_cast<int>(std::floor(fx))));
+  int z0 = std::max(0, std::min(_resolution - 2, static_cast<int>(std::floor(fz))));
+  float tx = std::max(0.0f, std::min(1.0f, fx - x0));
+  float tz = std::max(0.0f, std::min(1.0f, fz - z0));
+
+  int i00 = z0 * _resolution + x0, i10 = i00 + 1, i01 = i00 + _resolution, i11 = i01 + 1;
+  Vector3f d((_dx[i00] * (1 - tx) + _dx[i10] * tx) * (1 - tz) + (_dx[i01] * (1 - tx) + _dx[i11] * tx) * tz,
+             0.0f,
+             (_dz[i00] * (1 - tx) + _dz[i10] * tx) * (1 - tz) + (_dz[i01] * (1 - tx) + _dz[i11] * tx) * tz);
+  if (d.x == 0.0f && d.z == 0.0f) {
+    return d;
+  }
+  return d.normalize();
+}
+
+void FlowField::clearOccupants() {
+  for (auto &occupants : _occupants) {
+    occupants.clear();
+  }
+}
+
+void FlowField::addOccupant(Displayable *occupant) {
+  Vector3f p = occupant->getCoordinates();
+  _occupants[bucket(p.z) * _buckets + bucket(p.x)].push_back({occupant, p});
+}
+
+Vector3f FlowField::separation(const Displayable *self, float radius) const {
+  Vector3f own = self->getCoordinates();
+  Vector3f push;
+  forEachNeighbour(own, [&](Displayable *other, const Vector3f &position) {
+    if (other == self) {
+      return false;
+    }
+    Vector3f away = own - position;
+    away.y = 0.0f;
+    float distance = std::sqrt(away.x * away.x + away.z * away.z);
+    if (distance > 0.0f && distance < radius) {
+      push = push + away * ((radius - distance) / (radius * distance));
+    }
+    return false;
+  });
+  return push;
+}
+
+int FlowField::bucket(float coordinate) const {
+  return std::max(0, std::min(_buckets - 1, static_cast<int>((coordinate + _extent) / _bucketSize)));
+}
+
+float FlowField::center(int cell) const {
+  return -_extent + (cell + 0.5f) * _cellSize;
+}
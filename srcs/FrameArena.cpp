@@ -0,0 +1,66 @@
+//
+//  FrameArena.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+#include <cstdint>
+
+#include "includes/FrameArena.hpp"
+
+std::mutex FrameArena::_registryLock;
+std::vector<FrameArena *> FrameArena::_registry;
+
+FrameArena &FrameArena::local() {
+  static thread_local FrameArena arena;
+  return arena;
+}
+
+void FrameArena::resetAll() {
+  std::lock_guard<std::mutex> lock(_registryLock);
+  for (FrameArena *arena : _registry) {
+    arena->reset();
+  }
+}
+
+FrameArena::FrameArena() : _block(0), _offset(0), _used(0) {
+  std::lock_guard<std::mutex> lock(_registryLock);
+  _registry.push_back(this);
+}
+
+FrameArena::~FrameArena() {
+  std::lock_guard<std::mutex> lock(_registryLock);
+  _registry.erase(std::remove(_registry.begin(), _registry.end(), this), _registry.end());
+}
+
+void *FrameArena::allocate(size_t bytes, size_t alignment) {
+  // Current block first, then the ones kept from previous ticks
+  for (; _block < _blocks.size(); ++_block, _offset = 0) {
+    Block &block = _blocks[_block];
+    auto base = reinterpret_cast<uintptr_t>(block.data.get());
+    size_t start = ((base + _offset + alignment - 1) & ~(alignment - 1)) - base;
+    if (start + bytes <= block.size) {
+      _offset = start + bytes;
+      _used += bytes;
+      return block.data.get() + start;
+    }
+  }
+
+  // Blocks are allocated with new[], aligned for any fundamental type
+  size_t size = std::max<size_t>(FRAME_ARENA_BLOCK_SIZE, bytes);
+  _blocks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+  _block = _blocks.size() - 1;
+  _offset = bytes;
+  _used += bytes;
+  return _blocks.back().data.get();
+}
+
+void FrameArena::reset() {
+  _block = 0;
+  _offset = 0;
+  _used = 0;
+}
+
+size_t FrameArena::used() const {
+  return _used;
+}
@@ -0,0 +1,45 @@
+//
+//  FramePacer.cpp
+//  IslandDefense3D
+//
+
+#include <cstdio>
+#include <thread>
+
+#include "includes/FramePacer.hpp"
+
+FramePacer::FramePacer() : _deadline(), _swap(0.0), _vsync(false) {}
+
+void FramePacer::wait() {
+  if (FRAME_RATE <= 0 || _vsync) {
+    return;
+  }
+  auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / FRAME_RATE));
+  Clock::time_point now = Clock::now();
+  if (_deadline == Clock::time_point() || now - _deadline > period) {
+    _deadline = now;
+  } else if (now < _deadline) {
+    std::this_thread::sleep_until(_deadline);
+  }
+  _deadline += period;
+}
+
+void FramePacer::swapped(double ms) {
+  if (FRAME_RATE <= 0) {
+    return;
+  }
+  double period = MILLI / FRAME_RATE;
+  _swap += (ms - _swap) * PACER_SWAP_SMOOTHING;
+
+  // Apart enough that a phase drift between sleeps and refreshes does not flip it
+  bool vsync = _vsync ? _swap > period * PACER_VSYNC_OFF : _swap > period * PACER_VSYNC_ON;
+  if (vsync != _vsync) {
+    _vsync = vsync;
+    _deadline = Clock::time_point();
+    fprintf(stderr, "pacer: %s\n", _vsync ? "swaps block, vsync paces frames" : "swaps return, pacing frames");
+  }
+}
+
+bool FramePacer::getVsync() const {
+  return _vsync;
+}
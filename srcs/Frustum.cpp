@@ -0,0 +1,67 @@
+//
+//  Frustum.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "includes/Frustum.hpp"
+
+static float dot(const Vector3f &a, const Vector3f &b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Frustum::Frustum() : _count(0), _near(0.0f), _focal(0.0f) {}
+
+Frustum::Frustum(const Vector3f &eye, const Vector3f corners[4], const Vector3f &forward, float near, float far,
+                 float focal)
+    : _count(6), _eye(eye), _near(near), _focal(focal) {
+  Vector3f f = forward;
+  f.normalize();
+
+  // Sides through the eye and two neighbouring corners, turned to face the middle of the view
+  for (int k = 0; k < 4; ++k) {
+    Vector3f normal = Vector3f::cross(corners[k], corners[(k + 1) % 4]);
+    if (dot(normal, f) < 0.0f) {
+      normal = normal * -1.0f;
+    }
+    normal.normalize();
+    _planes[k] = {normal, -dot(normal, eye)};
+  }
+  _planes[4] = {f, -dot(f, eye) - near};
+  _planes[5] = {f * -1.0f, dot(f, eye) + far};
+}
+
+bool Frustum::sphere(const Vector3f &center, float radius) const {
+  for (int k = 0; k < _count; ++k) {
+    if (dot(_planes[k].normal, center) + _planes[k].offset < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Frustum::box(const BoundingBox &box) const {
+  for (int k = 0; k < _count; ++k) {
+    // Corner of the box furthest along the plane's normal
+    const Vector3f &n = _planes[k].normal;
+    Vector3f p(n.x >= 0.0f ? box.vecMax.x : box.vecMin.x,
+               n.y >= 0.0f ? box.vecMax.y : box.vecMin.y,
+               n.z >= 0.0f ? box.vecMax.z : box.vecMin.z);
+    if (dot(n, p) + _planes[k].offset < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+float Frustum::screenSize(const Vector3f &center, float radius) const {
+  if (_count == 0) {
+    return std::numeric_limits<float>::max();
+  }
+  // Distance rather than depth, so a mesh does not change level as the view turns
+  Vector3f d = center - _eye;
+  return radius * _focal / std::max(std::sqrt(dot(d, d)), _near);
+}
@@ -5,6 +5,7 @@
 //  Created by Mathieu Corti on 3/12/18.
 //
 
+#include <cstdlib>
 #include <vector>
 #include <random>
 
@@ -16,8 +17,27 @@
 #include "includes/Island.hpp"
 #include "includes/Light.hpp"
 #include "includes/GameUi.hpp"
+#include "includes/JobSystem.hpp"
+#include "includes/Profiler.hpp"
+#include "includes/PerfCounters.hpp"
+#include "includes/AllocTracker.hpp"
+#include "includes/FrameArena.hpp"
+#include "includes/Picking.hpp"
 #include "helpers/DefeatScreen.hpp"
 
+// Profiler scope names, one row per GameEntity: prepare, detect, update, draw
+static const char *const PROFILE_NAMES[GAME_ENTITIES_EOF][4] = {
+    {"Camera::prepare", "Camera::detect", "Camera::update", "Camera::draw"},
+    {"Light::prepare", "Light::detect", "Light::update", "Light::draw"},
+    {"Island::prepare", "Island::detect", "Island::update", "Island::draw"},
+    {"Axes::prepare", "Axes::detect", "Axes::update", "Axes::draw"},
+    {"Skybox::prepare", "Skybox::detect", "Skybox::update", "Skybox::draw"},
+    {"Boats::prepare", "Boats::detect", "Boats::update", "Boats::draw"},
+    {"Waves::prepare", "Waves::detect", "Waves::update", "Waves::draw"},
+    {"Stats::prepare", "Stats::detect", "Stats::update", "Stats::draw"},
+    {"GameUi::prepare", "GameUi::detect", "GameUi::update", "GameUi::draw"},
+};
+
 // PUBLIC
 int Game::start(int argc, char **argv) {
   // Init
@@ -35,13 +55,35 @@ int Game::start(int argc, char **argv) {
   initMouseCallback();
   glutIdleFunc(idleFunc);
   initEntities();
+#ifdef PROFILING
+  // Constructed before registering, so it is destroyed after the export
+  Profiler::getInstance();
+  std::atexit([]() { Profiler::getInstance().exportTrace(); });
+#endif
   glutMainLoop();
   return EXIT_SUCCESS;
 }
 
+void Game::startHeadless() {
+  _headless = true;
+  initEntities();
+}
+
+void Game::tick(float seconds) {
+  _clock += seconds;
+  update();
+}
+
 void Game::idleFunc() {
-  Game::getInstance().update();
+  Game &game = Game::getInstance();
+  game._pacer.wait();
+  game.update();
   glutPostRedisplay();
+
+  // Nothing moves on the defeat screen, only window events redraw it from now on
+  if (game.gameOver()) {
+    glutIdleFunc(nullptr);
+  }
 }
 
 bool Game::gameOver() const {
@@ -49,35 +91,110 @@ bool Game::gameOver() const {
 }
 
 void Game::update() {
+  PROFILE_SCOPE("Game::update");
+  double start = PerfCounters::now();
   if (gameOver()) {
 
   }
 
   updateTime();
+  _governor.update(_time, _updateWork + _drawWork);
+  _scheduler.beginTick(getTime());
   generateBoats();
 
-  // Update entities
+  // Entities are only added and removed during the serial phase, the index is read from prepare() on
+  snapshotCollidables();
+  _spatial.build(_components);
+  _flowField.clearOccupants();
+  for (auto boat : _collidables[BOATS]) {
+    _flowField.addOccupant(boat);
+  }
+
+  // Parallel phase, entities only touch their own state
+  JobSystem &jobs = JobSystem::getInstance();
+  {
+    PROFILE_SCOPE("Game::prepare");
+    jobs.submit([this, &jobs]() {
+      PROFILE_SCOPE("Systems::ballistics");
+      jobs.parallelFor(_components.size(), JOB_GRAIN * 8, [this](size_t begin, size_t end) {
+        Systems::ballistics(_components, getTime(), begin, end);
+      });
+    });
+    for (auto &entity : _entities) {
+      Displayable *displayable = entity.second.get();
+      GameEntity type = entity.first;
+      jobs.submit([displayable, type]() {
+        PROFILE_SCOPE(PROFILE_NAMES[type][0]);
+        ALLOC_TAG(type);
+        double start = PerfCounters::now();
+        displayable->prepare();
+        PerfCounters::getInstance().addTime(type, PerfCounters::PREPARE, start);
+      });
+    }
+    jobs.waitAll();
+  }
+  {
+    PROFILE_SCOPE("Systems::colliders");
+    jobs.parallelFor(_components.size(), JOB_GRAIN * 8, [this](size_t begin, size_t end) {
+      Systems::colliders(_components, begin, end);
+    });
+    Systems::targets(_components, _targets, _targetBounds);
+  }
+
+  // Detection phase, collisions are queued and resolved in one batch
+  {
+    PROFILE_SCOPE("Game::detect");
+    for (auto &entity : _entities) {
+      Displayable *displayable = entity.second.get();
+      GameEntity type = entity.first;
+      jobs.submit([displayable, type]() {
+        PROFILE_SCOPE(PROFILE_NAMES[type][1]);
+        ALLOC_TAG(type);
+        double start = PerfCounters::now();
+        displayable->detect();
+        PerfCounters::getInstance().addTime(type, PerfCounters::DETECT, start);
+      });
+    }
+    jobs.waitAll();
+  }
+  {
+    PROFILE_SCOPE("CollisionQueue::resolve");
+    _collisions.resolve();
+  }
+
+  // Serial phase, side effects (spawns, removals) are applied in entity order
   for (auto it = _entities.cbegin(); it != _entities.cend();) {
-    it->second->update();
+    {
+      PROFILE_SCOPE(PROFILE_NAMES[it->first][2]);
+      ALLOC_TAG(it->first);
+      double start = PerfCounters::now();
+      it->second->update();
+      PerfCounters::getInstance().addTime(it->first, PerfCounters::UPDATE, start);
+    }
     if (!it->second->isDisplayed()) {
       it = _entities.erase(it++);
     } else {
       ++it;
     }
   }
+  FrameArena::resetAll();
+  jobs.sample();
+  _updateWork = static_cast<float>(PerfCounters::now() - start);
 }
 
 void Game::draw() {
+  PROFILE_SCOPE("Game::draw");
+  double start = PerfCounters::now();
   glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
   glLoadIdentity();
   glMatrixMode(GL_PROJECTION);
   glLoadIdentity();
-  gluPerspective(75.0f, 1.0f, 0.01f, 3.0f);
+  gluPerspective(CAMERA_FOV, 1.0f, CAMERA_NEAR, CAMERA_FAR);
   glMatrixMode(GL_MODELVIEW);
 
-  glEnable(GL_DEPTH_TEST);
+  GlState::enable(GL_DEPTH_TEST);
 
   if (_showWireframe) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -86,8 +203,14 @@ void Game::draw() {
   }
 
   if (!gameOver()) {
+    // Same aspect as the projection above
+    _frustum = std::dynamic_pointer_cast<Camera>(_entities[GameEntity::CAMERA])->frustum(1.0f);
     for (const auto &entity : _entities) {
+      PROFILE_SCOPE(PROFILE_NAMES[entity.first][3]);
+      ALLOC_TAG(entity.first);
+      double start = PerfCounters::now();
       entity.second->draw();
+      PerfCounters::getInstance().addTime(entity.first, PerfCounters::DRAW, start);
       for (GLenum err = 0; (err = glGetError());) {
         printf("%s\n", gluErrorString(err));
       }
@@ -98,8 +221,15 @@ void Game::draw() {
   }
 
   _frames++;
+  _drawWork = static_cast<float>(PerfCounters::now() - start);
 
-  glutSwapBuffers();
+  {
+    PROFILE_SCOPE("glutSwapBuffers");
+    double swap = PerfCounters::now();
+    glutSwapBuffers();
+    _pacer.swapped(PerfCounters::now() - swap);
+  }
+  PerfCounters::getInstance().endFrame();
 }
 
 void Game::keyboard(unsigned char key, int x, int y) const {
@@ -122,8 +252,22 @@ void Game::keyboard(unsigned char key, int x, int y) const {
 
 void Game::mouse(int x, int y) {
   static auto camera = std::dynamic_pointer_cast<Camera>(_entities[GameEntity::CAMERA]);
+  static auto island = std::dynamic_pointer_cast<Island>(_entities[GameEntity::ISLAND]);
   camera->rotation(x, y);
-  setCannonRotation<Island>(GameEntity::ISLAND, camera->getYRot(), camera->getXRot());
+
+  // The cannon shoots at whatever is under the cursor, and follows the camera when that is the sky
+  Ray ray = camera->ray(2.0f * x / glutGet(GLUT_WINDOW_WIDTH) - 1.0f, 1.0f - 2.0f * y / glutGet(GLUT_WINDOW_HEIGHT));
+  Picking::Hit hit = Picking::pick(ray, CAMERA_FAR, &island->getHeightfield(), _spatial, _components);
+  int assisted;
+  if (hit.target == Picking::NOTHING) {
+    setCannonRotation<Island>(GameEntity::ISLAND, camera->getYRot(), camera->getXRot());
+  } else if (hit.target != Picking::BOAT &&
+             _spatial.nearest(hit.point, LAYER(BOAT_LAYER), AIM_ASSIST_RADIUS, &assisted, 1) == 1) {
+    // Near misses go to the closest boat
+    island->getCannon()->aimAt(_components.positions[assisted]);
+  } else {
+    island->getCannon()->aimAt(hit.point);
+  }
 }
 
 void Game::mouseClick(int button, int state) {
@@ -139,6 +283,9 @@ void Game::mouseClick(int button, int state) {
 void Game::initKeyboardMap() {
   _keyboardMap = {
       {27,  [](int, int) { exit(EXIT_SUCCESS); }},
+#ifdef PROFILING
+      {'P', [](int, int) { Profiler::getInstance().exportTrace(); }},
+#endif
 
 
       // CAMERA COMMANDS TODO : figure if we leave them
@@ -156,6 +303,7 @@ void Game::initKeyboardMap() {
       {'t', [this](int, int) { _showTangeant = !_showTangeant; }},
       {'i', [this](int, int) { _showWireframe = !_showWireframe; }},
       {'l', [this](int, int) { _showLight = !_showLight; }},
+      {'o', [this](int, int) { _showOverlay = !_showOverlay; }},
 
       // WAVES COMMANDS
       {'p', [this](int, int) { toggleAnimation(GameEntity::WAVES); }},
@@ -199,17 +347,34 @@ void Game::initEntities() {
   _entities.insert(std::make_pair(GameEntity::LIGHT, std::make_shared<Light>()));
   _entities.insert(std::make_pair(GameEntity::STATS, std::make_shared<Stats>()));
   _entities.insert(std::make_pair(GameEntity::WAVES, std::make_shared<Waves>()));
-  _entities.insert(std::make_pair(GameEntity::SKYBOX, std::make_shared<Skybox>()));
+  if (!_headless) {
+    // Its textures would never be uploaded without a GL context
+    _entities.insert(std::make_pair(GameEntity::SKYBOX, std::make_shared<Skybox>()));
+  }
   auto island = std::make_shared<Island>();
   GameUi::Entities entities = {std::make_pair(std::dynamic_pointer_cast<Alive>(island), GREEN)};
   _entities.insert(std::make_pair(GameEntity::ISLAND, island));
+  BoundingBox shore = island->getShapes().front().get_boundingBox();
+  for (const Shape &row : island->getShapes()) {
+    BoundingBox box = row.get_boundingBox();
+    shore.vecMin = Vector3f(std::min(shore.vecMin.x, box.vecMin.x), 0.0f, std::min(shore.vecMin.z, box.vecMin.z));
+    shore.vecMax = Vector3f(std::max(shore.vecMax.x, box.vecMax.x), 0.0f, std::max(shore.vecMax.z, box.vecMax.z));
+  }
+  _flowField.buildAsync(shore, {});
   _entities.insert(std::make_pair(GameEntity::BOATS, generateBoats()));
   _entities.insert(std::make_pair(GameEntity::UI, std::make_shared<GameUi>(entities)));
+  if (!_headless) {
+    // Once every entity exists: the island shades itself with the light's position,
+    // the skybox uploads what the workers decoded meanwhile
+    for (const auto &entity : _entities) {
+      entity.second->bake();
+    }
+  }
 //  _entities.insert(std::make_pair(GameEntity::AXES, std::make_shared<Axes>()));
 }
 
 std::shared_ptr<Entities<Boat> > Game::generateBoats() {
-  static auto boats = std::make_shared<Entities<Boat> >();
+  static auto boats = std::make_shared<Entities<Boat> >(MAX_BOATS);
   static float lastGeneration = -BOAT_GEN_DELTA;
 
   if (_time -lastGeneration < BOAT_GEN_DELTA) {
@@ -224,10 +389,10 @@ std::shared_ptr<Entities<Boat> > Game::generateBoats() {
   std::uniform_real_distribution<float> disColor(0.0f, 1.0f);
 
   for (int i = 0; i < NBR_BOATS_PER_GEN && boats->size() < MAX_BOATS; ++i) {
-    boats->add(std::make_shared<Boat>(Color(disColor(gen), disColor(gen), disColor(gen), 1.0f),
-                                      Vector3f(disMinus(genMin) != 0 ? dis(genX) : -dis(genX),
-                                               0.0f,
-                                               disMinus(genMin) != 0 ? dis(genZ) : -dis(genZ))));
+    boats->spawn(Color(disColor(gen), disColor(gen), disColor(gen), 1.0f),
+                 Vector3f(disMinus(genMin) != 0 ? dis(genX) : -dis(genX),
+                          0.0f,
+                          disMinus(genMin) != 0 ? dis(genZ) : -dis(genZ)));
   }
 
   return boats;
@@ -242,18 +407,19 @@ const float &Game::getDeltaTime() const {
 }
 
 void Game::updateTime() {
-  _time = glutGet(GLUT_ELAPSED_TIME) / MILLI;
+  _time = _headless ? _clock : glutGet(GLUT_ELAPSED_TIME) / MILLI;
 
   if (_lastTime == 0.0) {
-    _lastTime = _time;
+    _lastTime = _lastFrameRateT = _time;
     return;
   }
 
+  _deltaTime = _time - _lastTime;
   _lastTime = _time;
 
-  _deltaTime = _time - _lastFrameRateT;
-  if (_deltaTime > _frameRateInterval) {
-    _frameRate = _frames / _deltaTime;
+  float window = _time - _lastFrameRateT;
+  if (window > _frameRateInterval) {
+    _frameRate = _frames / window;
     _lastFrameRateT = _time;
     _frames = 0;
   }
@@ -263,10 +429,66 @@ const float &Game::getFrameRate() const {
   return _frameRate;
 }
 
+void Game::snapshotCollidables() {
+  _allCollidables.clear();
+  for (auto &collidables : _collidables) {
+    collidables.clear();
+  }
+  for (auto &entity : _entities) {
+    std::vector<Displayable *> &collidables = _collidables[entity.first];
+    entity.second->getCollidables(collidables);
+    _allCollidables.insert(_allCollidables.end(), collidables.begin(), collidables.end());
+  }
+}
+
+const std::vector<Displayable *> &Game::getCollidables(GameEntity entity) const {
+  return _collidables[entity];
+}
+
+const std::vector<Displayable *> &Game::getCollidables() const {
+  return _allCollidables;
+}
+
 const Game::EntityList &Game::getEntities() const {
   return _entities;
 }
 
+AIScheduler &Game::getScheduler() {
+  return _scheduler;
+}
+
+FlowField &Game::getFlowField() {
+  return _flowField;
+}
+
+Components &Game::getComponents() {
+  return _components;
+}
+
+CollisionQueue &Game::getCollisions() {
+  return _collisions;
+}
+
+const OrientedBoxes &Game::getTargets(CollisionLayer layer) const {
+  return _targets[layer];
+}
+
+const AlignedBoxes &Game::getTargetBounds(CollisionLayer layer) const {
+  return _targetBounds[layer];
+}
+
+const Frustum &Game::getFrustum() const {
+  return _frustum;
+}
+
+const SpatialIndex &Game::getSpatialIndex() const {
+  return _spatial;
+}
+
+const Governor &Game::getGovernor() const {
+  return _governor;
+}
+
 const bool Game::getShowTangeant() const {
   return _showTangeant;
 }
@@ -279,6 +501,10 @@ const bool Game::getShowLight() const {
   return _showLight;
 }
 
+const bool Game::getShowOverlay() const {
+  return _showOverlay;
+}
+
 // EXTERN C
 extern "C" {
 static void drawCallback() {
@@ -288,7 +514,7 @@ static void reshapeCallback(int w, int h) {
   glViewport(0, 0, (GLsizei) w, (GLsizei) h);
   glMatrixMode(GL_PROJECTION);
   glLoadIdentity();
-  gluPerspective(75.0f, (GLfloat) w / (GLfloat) h, 0.01f, 3.0);
+  gluPerspective(CAMERA_FOV, (GLfloat) w / (GLfloat) h, CAMERA_NEAR, CAMERA_FAR);
   glMatrixMode(GL_MODELVIEW);
 }
 static void keyboardCallback(unsigned char key, int x, int y) {
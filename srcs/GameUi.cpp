@@ -20,7 +20,7 @@ void GameUi::draw() const {
   glOrtho(-1.0, 1.0, -1.0, 1.0, -2.0, 2.0);
   glMatrixMode(GL_MODELVIEW);
   glLoadIdentity();
-  glDisable(GL_CULL_FACE);
+  GlState::disable(GL_CULL_FACE);
 
   glClear(GL_DEPTH_BUFFER_BIT);
 
@@ -0,0 +1,168 @@
+//
+//  Governor.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+#include <cstdio>
+
+#include "includes/Governor.hpp"
+
+enum Rung {
+  LOWER_TRAJECTORY,
+  LOWER_SPHERE,
+  LOWER_COLLISIONS,
+  LOWER_TESSELLATION,
+  LOWER_BOATS
+};
+
+// Least visible trade first, each rung halves one knob again
+static const Rung LADDER[] = {
+    LOWER_TRAJECTORY, LOWER_SPHERE, LOWER_COLLISIONS, LOWER_TESSELLATION, LOWER_BOATS,
+    LOWER_TRAJECTORY, LOWER_SPHERE, LOWER_COLLISIONS, LOWER_TESSELLATION, LOWER_BOATS,
+    LOWER_TESSELLATION,
+};
+static const int LADDER_SIZE = sizeof LADDER / sizeof *LADDER;
+
+Governor::Governor() : _started(false), _best(), _player(), _applied(), _level(0), _average(0.0f),
+                       _overSince(-1.0f), _underSince(-1.0f), _lastStep(0.0f) {}
+
+void Governor::update(float time, float workMs) {
+  if (GOVERNOR_TARGET_MS <= 0.0f) {
+    return;
+  }
+  if (!_started) {
+    _started = true;
+    _best = {WAVES_TESSELLATION, SPHERE_SLICES, TRAJECTORY_STEP, MAX_BOATS, CHECK_COLLISIONS_EVERY};
+    _player = _applied = _best;
+    _average = workMs;
+    _lastStep = time;
+  }
+  if (adopt()) {
+    write(effective(_level));
+  }
+  _average += (workMs - _average) * GOVERNOR_SMOOTHING;
+
+  bool over = _average > GOVERNOR_TARGET_MS * GOVERNOR_LOWER_ABOVE;
+  bool under = _average < GOVERNOR_TARGET_MS * GOVERNOR_RAISE_BELOW;
+  _overSince = !over ? -1.0f : _overSince < 0.0f ? time : _overSince;
+  _underSince = !under ? -1.0f : _underSince < 0.0f ? time : _underSince;
+  if (time - _lastStep < GOVERNOR_COOLDOWN) {
+    return;
+  }
+
+  // Raising waits twice as long, a spike should not make quality flicker
+  if (over && _level < LADDER_SIZE && time - _overSince >= GOVERNOR_HOLD) {
+    apply(_level + 1);
+    _lastStep = time;
+  } else if (under && _level > 0 && time - _underSince >= GOVERNOR_HOLD * 2.0f) {
+    apply(_level - 1);
+    _lastStep = time;
+  }
+}
+
+int Governor::getLevel() const {
+  return _level;
+}
+
+float Governor::getAverage() const {
+  return _average;
+}
+
+Governor::Knobs Governor::knobs(int level) const {
+  Knobs k = _best;
+  for (int i = 0; i < level; ++i) {
+    switch (LADDER[i]) {
+      case LOWER_TRAJECTORY:
+        k.trajectoryStep = std::min(k.trajectoryStep * 2.0f, std::max(_best.trajectoryStep, GOVERNOR_MAX_TRAJECTORY_STEP));
+        break;
+      case LOWER_SPHERE:
+        k.sphereSlices = std::max(k.sphereSlices / 2, std::min(_best.sphereSlices, GOVERNOR_MIN_SPHERE_SLICES));
+        break;
+      case LOWER_COLLISIONS:
+        k.checkCollisionsEvery = std::min(k.checkCollisionsEvery * 1.5f,
+                                          std::max(_best.checkCollisionsEvery, GOVERNOR_MAX_CHECK_COLLISIONS_EVERY));
+        break;
+      case LOWER_TESSELLATION:
+        k.tessellation = std::max(k.tessellation / 2, std::min(_best.tessellation, GOVERNOR_MIN_TESSELLATION));
+        break;
+      case LOWER_BOATS:
+        k.maxBoats = std::max(k.maxBoats * 3 / 4, std::min(_best.maxBoats, GOVERNOR_MIN_BOATS));
+        break;
+    }
+  }
+  return k;
+}
+
+Governor::Knobs Governor::effective(int level) const {
+  Knobs limit = knobs(level);
+  Knobs k;
+  k.tessellation = std::min(_player.tessellation, limit.tessellation);
+  k.sphereSlices = std::min(_player.sphereSlices, limit.sphereSlices);
+  k.trajectoryStep = std::max(_player.trajectoryStep, limit.trajectoryStep);
+  k.maxBoats = std::min(_player.maxBoats, limit.maxBoats);
+  k.checkCollisionsEvery = std::max(_player.checkCollisionsEvery, limit.checkCollisionsEvery);
+  return k;
+}
+
+bool Governor::adopt() {
+  Knobs current = {WAVES_TESSELLATION, SPHERE_SLICES, TRAJECTORY_STEP, MAX_BOATS, CHECK_COLLISIONS_EVERY};
+  bool changed = false;
+  if (current.tessellation != _applied.tessellation) {
+    _player.tessellation = current.tessellation;
+    changed = true;
+  }
+  if (current.sphereSlices != _applied.sphereSlices) {
+    _player.sphereSlices = current.sphereSlices;
+    changed = true;
+  }
+  if (current.trajectoryStep != _applied.trajectoryStep) {
+    _player.trajectoryStep = current.trajectoryStep;
+    changed = true;
+  }
+  if (current.maxBoats != _applied.maxBoats) {
+    _player.maxBoats = current.maxBoats;
+    changed = true;
+  }
+  if (current.checkCollisionsEvery != _applied.checkCollisionsEvery) {
+    _player.checkCollisionsEvery = current.checkCollisionsEvery;
+    changed = true;
+  }
+  return changed;
+}
+
+void Governor::write(const Knobs &knobs) {
+  Settings &settings = Settings::current;
+  settings.trajectoryStep = knobs.trajectoryStep;
+  settings.sphereSlices = knobs.sphereSlices;
+  settings.checkCollisionsEvery = knobs.checkCollisionsEvery;
+  settings.wavesTessellation = knobs.tessellation;
+  settings.maxBoats = knobs.maxBoats;
+  _applied = knobs;
+}
+
+void Governor::apply(int level) {
+  Knobs from = effective(_level);
+  Knobs to = effective(level);
+  fprintf(stderr, "governor: %.1f ms against a %.1f ms target, level %d -> %d\n",
+          _average, GOVERNOR_TARGET_MS, _level, level);
+  if (from.trajectoryStep != to.trajectoryStep) {
+    fprintf(stderr, "governor:   trajectory_step %g -> %g\n", from.trajectoryStep, to.trajectoryStep);
+  }
+  if (from.sphereSlices != to.sphereSlices) {
+    fprintf(stderr, "governor:   sphere_slices %d -> %d\n", from.sphereSlices, to.sphereSlices);
+  }
+  if (from.checkCollisionsEvery != to.checkCollisionsEvery) {
+    fprintf(stderr, "governor:   check_collisions_every %g -> %g\n", from.checkCollisionsEvery,
+            to.checkCollisionsEvery);
+  }
+  if (from.tessellation != to.tessellation) {
+    fprintf(stderr, "governor:   waves_tessellation %d -> %d\n", from.tessellation, to.tessellation);
+  }
+  if (from.maxBoats != to.maxBoats) {
+    fprintf(stderr, "governor:   max_boats %d -> %d\n", from.maxBoats, to.maxBoats);
+  }
+
+  write(to);
+  _level = level;
+}
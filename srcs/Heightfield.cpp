@@ -0,0 +1,263 @@
+//
+//  Heightfield.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "includes/Heightfield.hpp"
+
+static float dot(const Vector3f &a, const Vector3f &b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+/// Narrows [t0, t1] to where p + d * t lies within [lo, hi] on one axis
+static bool clip(float p, float d, float lo, float hi, float &t0, float &t1) {
+  if (d == 0.0f) {
+    return p >= lo && p <= hi;
+  }
+  float ta = (lo - p) / d;
+  float tb = (hi - p) / d;
+  if (ta > tb) {
+    std::swap(ta, tb);
+  }
+  t0 = std::max(t0, ta);
+  t1 = std::min(t1, tb);
+  return t0 <= t1;
+}
+
+/// Closest point to p on the triangle abc, Ericson's Real-Time Collision Detection 5.1.5
+static Vector3f closestOnTriangle(const Vector3f &p, const Vector3f &a, const Vector3f &b, const Vector3f &c) {
+  Vector3f ab = b - a, ac = c - a, ap = p - a;
+  float d1 = dot(ab, ap), d2 = dot(ac, ap);
+  if (d1 <= 0.0f && d2 <= 0.0f) {
+    return a;
+  }
+  Vector3f bp = p - b;
+  float d3 = dot(ab, bp), d4 = dot(ac, bp);
+  if (d3 >= 0.0f && d4 <= d3) {
+    return b;
+  }
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+    return a + ab * (d1 / (d1 - d3));
+  }
+  Vector3f cp = p - c;
+  float d5 = dot(ab, cp), d6 = dot(ac, cp);
+  if (d6 >= 0.0f && d5 <= d6) {
+    return c;
+  }
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+    return a + ac * (d2 / (d2 - d6));
+  }
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  }
+  float denom = 1.0f / (va + vb + vc);
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+Heightfield::Heightfield() : _step(1.0f), _resolution(0) {}
+
+Heightfield::Heightfield(const Vector3f &origin, float step, int resolution, std::vector<float> heights)
+    : _origin(origin), _step(step), _resolution(resolution), _heights(std::move(heights)) {
+  // Cells first, each one bounded by its four corners
+  Level cells{_resolution, std::vector<float>(_resolution * _resolution), std::vector<float>(_resolution * _resolution)};
+  for (int i = 0; i < _resolution; ++i) {
+    for (int j = 0; j < _resolution; ++j) {
+      float h[] = {sample(i, j), sample(i, j + 1), sample(i + 1, j), sample(i + 1, j + 1)};
+      cells.min[i * _resolution + j] = *std::min_element(h, h + 4);
+      cells.max[i * _resolution + j] = *std::max_element(h, h + 4);
+    }
+  }
+  _levels.push_back(std::move(cells));
+
+  // Then every level folds 2x2 nodes of the previous one, odd sizes round up
+  while (_levels.back().size > 1) {
+    const Level &below = _levels.back();
+    int size = (below.size + 1) / 2;
+    Level level{size, std::vector<float>(size * size, 0.0f), std::vector<float>(size * size, 0.0f)};
+    for (int i = 0; i < size; ++i) {
+      for (int j = 0; j < size; ++j) {
+        bool first = true;
+        for (int ci = 2 * i; ci < std::min(2 * i + 2, below.size); ++ci) {
+          for (int cj = 2 * j; cj < std::min(2 * j + 2, below.size); ++cj) {
+            float low = below.min[ci * below.size + cj], high = below.max[ci * below.size + cj];
+            level.min[i * size + j] = first ? low : std::min(level.min[i * size + j], low);
+            level.max[i * size + j] = first ? high : std::max(level.max[i * size + j], high);
+            first = false;
+          }
+        }
+      }
+    }
+    _levels.push_back(std::move(level));
+  }
+}
+
+bool Heightfield::contains(float x, float z) const {
+  float extent = _resolution * _step;
+  return x >= _origin.x && x <= _origin.x + extent && z >= _origin.z && z <= _origin.z + extent;
+}
+
+float Heightfield::height(float x, float z) const {
+  float u = (x - _origin.x) / _step, v = (z - _origin.z) / _step;
+  int j = std::max(0, std::min(static_cast<int>(std::floor(u)), _resolution - 1));
+  int i = std::max(0, std::min(static_cast<int>(std::floor(v)), _resolution - 1));
+  return cellHeight(i, j, u - j, v - i);
+}
+
+float Heightfield::maxHeight() const {
+  return _levels.empty() ? _origin.y : _levels.back().max[0];
+}
+
+bool Heightfield::intersectSegment(const Vector3f &from, const Vector3f &to, float &t) const {
+  if (_levels.empty()) {
+    return false;
+  }
+  return segmentNode(static_cast<int>(_levels.size()) - 1, 0, 0, from, to - from, 0.0f, 1.0f, t);
+}
+
+bool Heightfield::overlapsSphere(const Vector3f &center, float radius) const {
+  if (_levels.empty()) {
+    return false;
+  }
+  return sphereNode(static_cast<int>(_levels.size()) - 1, 0, 0, center, radius);
+}
+
+float Heightfield::sample(int i, int j) const {
+  return _heights[i * (_resolution + 1) + j];
+}
+
+float Heightfield::cellHeight(int i, int j, float fx, float fz) const {
+  fx = std::max(0.0f, std::min(fx, 1.0f));
+  fz = std::max(0.0f, std::min(fz, 1.0f));
+
+  // Same split as the island mesh, along the diagonal from (j + 1, i) to (j, i + 1)
+  if (fx + fz <= 1.0f) {
+    float h1 = sample(i, j);
+    return h1 + fx * (sample(i, j + 1) - h1) + fz * (sample(i + 1, j) - h1);
+  }
+  float h4 = sample(i + 1, j + 1);
+  return h4 + (1.0f - fx) * (sample(i + 1, j) - h4) + (1.0f - fz) * (sample(i, j + 1) - h4);
+}
+
+bool Heightfield::segmentNode(int level, int i, int j, const Vector3f &from, const Vector3f &delta, float t0,
+                              float t1, float &t) const {
+  int span = 1 << level;
+  float x0 = _origin.x + j * span * _step, x1 = _origin.x + std::min((j + 1) * span, _resolution) * _step;
+  float z0 = _origin.z + i * span * _step, z1 = _origin.z + std::min((i + 1) * span, _resolution) * _step;
+  if (!clip(from.x, delta.x, x0, x1, t0, t1) || !clip(from.z, delta.z, z0, z1, t0, t1)) {
+    return false;
+  }
+
+  // The part of the segment over this node passes above everything below it
+  const Level &node = _levels[level];
+  if (std::min(from.y + delta.y * t0, from.y + delta.y * t1) > node.max[i * node.size + j]) {
+    return false;
+  }
+  if (level == 0) {
+    return segmentCell(i, j, from, delta, t0, t1, t);
+  }
+
+  // Children nearest to `from` first, a hit then cuts the segment short for the others
+  bool hit = false;
+  const Level &below = _levels[level - 1];
+  int firstI = delta.z < 0.0f ? 1 : 0, firstJ = delta.x < 0.0f ? 1 : 0;
+  for (int k = 0; k < 4; ++k) {
+    int ci = 2 * i + (firstI ^ (k >> 1)), cj = 2 * j + (firstJ ^ (k & 1));
+    if (ci < below.size && cj < below.size && segmentNode(level - 1, ci, cj, from, delta, t0, t1, t)) {
+      t1 = t;
+      hit = true;
+    }
+  }
+  return hit;
+}
+
+bool Heightfield::segmentCell(int i, int j, const Vector3f &from, const Vector3f &delta, float t0, float t1,
+                              float &t) const {
+  float x0 = _origin.x + j * _step, z0 = _origin.z + i * _step;
+  auto above = [&](float at) {
+    float fx = (from.x + delta.x * at - x0) / _step, fz = (from.z + delta.z * at - z0) / _step;
+    return from.y + delta.y * at - cellHeight(i, j, fx, fz);
+  };
+  auto diagonal = [&](float at) {
+    return (from.x + delta.x * at - x0) / _step + (from.z + delta.z * at - z0) / _step - 1.0f;
+  };
+
+  // Height over the surface is linear on each triangle, so checking where the segment
+  // enters, crosses the diagonal and leaves is exact
+  float points[3] = {t0, t1, t1};
+  int count = 2;
+  float s0 = diagonal(t0), s1 = diagonal(t1);
+  if (s0 * s1 < 0.0f) {
+    points[1] = t0 + (t1 - t0) * s0 / (s0 - s1);
+    count = 3;
+  }
+  float a = points[0], fa = above(a);
+  if (fa <= 0.0f) {
+    t = a;
+    return true;
+  }
+  for (int k = 1; k < count; ++k) {
+    float b = points[k], fb = above(b);
+    if (fb <= 0.0f) {
+      t = a + (b - a) * fa / (fa - fb);
+      return true;
+    }
+    a = b;
+    fa = fb;
+  }
+  return false;
+}
+
+bool Heightfield::sphereNode(int level, int i, int j, const Vector3f &center, float radius) const {
+  int span = 1 << level;
+  float x0 = _origin.x + j * span * _step, x1 = _origin.x + std::min((j + 1) * span, _resolution) * _step;
+  float z0 = _origin.z + i * span * _step, z1 = _origin.z + std::min((i + 1) * span, _resolution) * _step;
+  float dx = std::max(std::max(x0 - center.x, center.x - x1), 0.0f);
+  float dz = std::max(std::max(z0 - center.z, center.z - z1), 0.0f);
+  const Level &node = _levels[level];
+  if (dx * dx + dz * dz > radius * radius || center.y - radius > node.max[i * node.size + j]) {
+    return false;
+  }
+  if (level == 0) {
+    return sphereCell(i, j, center, radius);
+  }
+
+  const Level &below = _levels[level - 1];
+  for (int ci = 2 * i; ci < std::min(2 * i + 2, below.size); ++ci) {
+    for (int cj = 2 * j; cj < std::min(2 * j + 2, below.size); ++cj) {
+      if (sphereNode(level - 1, ci, cj, center, radius)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool Heightfield::sphereCell(int i, int j, const Vector3f &center, float radius) const {
+  float x0 = _origin.x + j * _step, z0 = _origin.z + i * _step;
+
+  // Lowest point of the sphere over the nearest spot of the cell, this catches
+  // a center under the surface as well as spheres against the island's sides
+  float fx = std::max(0.0f, std::min((center.x - x0) / _step, 1.0f));
+  float fz = std::max(0.0f, std::min((center.z - z0) / _step, 1.0f));
+  float dx = x0 + fx * _step - center.x, dz = z0 + fz * _step - center.z;
+  if (center.y - std::sqrt(std::max(radius * radius - dx * dx - dz * dz, 0.0f)) <= cellHeight(i, j, fx, fz)) {
+    return true;
+  }
+
+  Vector3f p1(x0, sample(i, j), z0), p2(x0 + _step, sample(i, j + 1), z0);
+  Vector3f p3(x0, sample(i + 1, j), z0 + _step), p4(x0 + _step, sample(i + 1, j + 1), z0 + _step);
+  for (const Vector3f &closest : {closestOnTriangle(center, p1, p2, p3), closestOnTriangle(center, p3, p2, p4)}) {
+    Vector3f d = closest - center;
+    if (dot(d, d) <= radius * radius) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -6,16 +6,25 @@
 #include "helpers/Perlin.hpp"
 #include "includes/Waves.hpp"
 #include "includes/Game.hpp"
+#include "includes/Lod.hpp"
 
 Island::Island()
-    : Alive(ISLAND_BASE_HEALTH), _xmax(0.1f), _zmax(0.1f), _tess(64.0f), _maxHeight(-1.0f), _minHeight(-1.0f) {
+    : Alive(ISLAND_BASE_HEALTH), _xmax(0.1f), _zmax(0.1f), _tess(64.0f), _maxHeight(-1.0f), _minHeight(-1.0f),
+      _lod(0),
+      _bakedLight(false) {
+  _worldSpace = true;
   generateTopTriangles(ORANGE);
   for (Shape &shape : _shapes) {
     shape.computePerVertexNormal();
   }
+  // After the normals, coarser levels keep the smooth shading of the full mesh
+  int tess = static_cast<int>(_tess);
+  for (int level = 1; level < LOD_LEVELS; ++level) {
+    _levels.emplace_back();
+    generateRows(tess / Lod::segments(tess, level), ORANGE, _levels.back());
+  }
   _cannon = std::make_shared<Cannon>(1.0f, 0.012f, GREY);
   _cannon->setCoordinates(Vector3f(0, (_maxHeight + _minHeight) / 2.0f, 0));
-  _collidables.push_back(this);
 }
 
 void Island::generateTopTriangles(Color color) {
@@ -23,6 +32,7 @@ void Island::generateTopTriangles(Color color) {
   float zStep = 2 * _zmax / _tess;
 
   float z;
+  std::vector<float> heights;
   for (int i = 0; i <= _tess; ++i) {
     if (i == 0) {
       z = -_zmax;
@@ -47,6 +57,7 @@ void Island::generateTopTriangles(Color color) {
         row.emplace_back(std::make_shared<Vertex>(Vector3f(x, -0.8f, z)));
       }
       float y = islandPerlin(x, z);
+      heights.push_back(y);
       _maxHeight = _maxHeight == -1.0f ? y : std::max(_maxHeight, y);
       _minHeight = _minHeight == -1.0f ? y : std::min(_minHeight, y);
       row.emplace_back(std::make_shared<Vertex>(Vector3f(x, y, z)));
@@ -72,22 +83,44 @@ void Island::generateTopTriangles(Color color) {
     }
   }
 
-  for (int i = 0; i < _vertices.size() - 1; ++i) {
-    const std::vector<Vertex::Ptr> &pointRow = _vertices[i];
-    const std::vector<Vertex::Ptr> &pointUpRow = _vertices[i + 1];
+  _ground = Heightfield(Vector3f(-_xmax, 0.0f, -_zmax), xStep, static_cast<int>(_tess), std::move(heights));
+
+  generateRows(1, color, _shapes);
+}
+
+void Island::generateRows(int step, Color color, Shapes &shapes) const {
+  // Skirts stay, the surface keeps one sample out of `step`
+  int tess = static_cast<int>(_tess);
+  std::vector<int> kept{0};
+  for (int i = 0; i <= tess; i += step) {
+    kept.push_back(i + 1);
+  }
+  kept.push_back(tess + 2);
+
+  for (int i = 0; i < kept.size() - 1; ++i) {
+    const std::vector<Vertex::Ptr> &pointRow = _vertices[kept[i]];
+    const std::vector<Vertex::Ptr> &pointUpRow = _vertices[kept[i + 1]];
     std::vector<Triangle> parts;
-    for (int j = 0; j < pointRow.size() - 1; j++) {
-      const Vertex::Ptr p1 = pointRow.at(j);
-      const Vertex::Ptr p2 = pointRow.at(j + 1);
-      const Vertex::Ptr p3 = pointUpRow.at(j);
-      const Vertex::Ptr p4 = pointUpRow.at(j + 1);
+    BoundingBox bounds(pointRow.front()->p, pointRow.front()->p);
+    for (int j = 0; j < kept.size() - 1; j++) {
+      const Vertex::Ptr p1 = pointRow.at(kept[j]);
+      const Vertex::Ptr p2 = pointRow.at(kept[j + 1]);
+      const Vertex::Ptr p3 = pointUpRow.at(kept[j]);
+      const Vertex::Ptr p4 = pointUpRow.at(kept[j + 1]);
+      for (const Vertex::Ptr &v : {p1, p2, p3, p4}) {
+        bounds.vecMin = Vector3f(std::min(bounds.vecMin.x, v->p.x), std::min(bounds.vecMin.y, v->p.y),
+                                 std::min(bounds.vecMin.z, v->p.z));
+        bounds.vecMax = Vector3f(std::max(bounds.vecMax.x, v->p.x), std::max(bounds.vecMax.y, v->p.y),
+                                 std::max(bounds.vecMax.z, v->p.z));
+      }
 
       parts.emplace_back(p1, p2, p3, Triangle::computeNormal(p1->p, p2->p, p3->p));
       parts.emplace_back(p3, p2, p4, Triangle::computeNormal(p3->p, p2->p, p4->p));
     }
+    // Every corner rather than generateBoundingBox()'s first vertices, a row's last column counts for culling
     Shape shape = Shape(parts, GL_TRIANGLES, color);
-    shape.generateBoundingBox();
-    _shapes.emplace_back(shape);
+    shape.setBoundingBox(bounds);
+    shapes.emplace_back(shape);
   }
 }
 
@@ -97,11 +130,14 @@ float Island::islandPerlin(float x, float z) const {
 }
 
 void Island::draw() const {
-  if (Game::getInstance().getShowLight()) {
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_COLOR_MATERIAL);
-    glEnable(GL_NORMALIZE);
+  // Baked shading stands in for GL lighting on the ground, the cannon lights itself anyway
+  bool showLight = Game::getInstance().getShowLight();
+  bool lighting = showLight && !_bakedLight;
+  if (lighting) {
+    GlState::enable(GL_LIGHTING);
+    GlState::enable(GL_LIGHT0);
+    GlState::enable(GL_COLOR_MATERIAL);
+    GlState::enable(GL_NORMALIZE);
 
     GLfloat specular[] = {0.1f, 0.1f, 0.1f, 0.0f};
     glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
@@ -115,17 +151,42 @@ void Island::draw() const {
     glShadeModel(GL_SMOOTH);
   }
 
-  glEnable(GL_BLEND);
-  Displayable::draw();
+  // One level for the whole island, rows of different levels would leave cracks between them
+  float radius = std::sqrt(_xmax * _xmax + _zmax * _zmax);
+  Vector3f center(0.0f, (_maxHeight + _minHeight) / 2.0f, 0.0f);
+  float size = Game::getInstance().getFrustum().screenSize(center, radius);
+  _lod = GlState::lod(Lod::select(size, 2.0f * _xmax / radius, static_cast<int>(_tess), _lod));
+
+  GlState::enable(GL_BLEND);
+  drawShapes(_lod == 0 ? _shapes : _levels[_lod - 1], showLight);
   _cannon->draw();
-  glDisable(GL_BLEND);
+  GlState::disable(GL_BLEND);
+
+  if (lighting) {
+    GlState::disable(GL_NORMALIZE);
+    GlState::disable(GL_COLOR_MATERIAL);
+    GlState::disable(GL_LIGHT0);
+    GlState::disable(GL_LIGHTING);
+  }
+}
 
-  if (Game::getInstance().getShowLight()) {
-    glDisable(GL_NORMALIZE);
-    glDisable(GL_COLOR_MATERIAL);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_LIGHTING);
+void Island::bake() {
+  // The light never moves, so neither does its shading of the ground
+  Vector3f light = Game::getInstance().getEntities().at(LIGHT)->getCoordinates();
+  const Vector3f *shading = BAKE_LIGHTING ? &light : nullptr;
+  bool compiled = compile(_shapes, shading);
+  for (Shapes &level : _levels) {
+    compiled = compile(level, shading) && compiled;
   }
+  _bakedLight = shading && compiled;
+}
+
+void Island::prepare() {
+  _cannon->prepare();
+}
+
+void Island::detect() {
+  _cannon->detect();
 }
 
 void Island::update() {
@@ -136,11 +197,11 @@ Cannon::Ptr Island::getCannon() const {
   return _cannon;
 }
 
-const std::list<Displayable *> &Island::getCollidables() {
-  _collidables.clear();
-  for (auto e : _cannon->getCollidables()) {
-    _collidables.push_back(e);
-  }
-  _collidables.push_back(this);
-  return _collidables;
+const Heightfield &Island::getHeightfield() const {
+  return _ground;
+}
+
+void Island::getCollidables(std::vector<Displayable *> &collidables) {
+  _cannon->getCollidables(collidables);
+  collidables.push_back(this);
 }
\ No newline at end of file
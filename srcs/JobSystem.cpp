@@ -0,0 +1,214 @@
+//
+//  JobSystem.cpp
+//  IslandDefense3D
+//
+
+#include <stdexcept>
+
+#include "includes/JobSystem.hpp"
+#include "includes/AllocTracker.hpp"
+
+thread_local unsigned int JobSystem::_self = 0;
+
+JobSystem::JobSystem(unsigned int workers) : _count(0), _running(true), _queued(0), _outstanding(0),
+                                             _lastSample(std::chrono::steady_clock::now()) {
+  if (workers == 0) {
+    unsigned int cores = std::thread::hardware_concurrency();
+    workers = cores > 1 ? cores - 1 : 0;
+  }
+
+  _busy.reset(new std::atomic<long long>[workers + 1]);
+  for (unsigned int i = 0; i <= workers; ++i) {
+    _queues.emplace_back(new Queue());
+    _busy[i] = 0;
+  }
+  _utilization.assign(workers + 1, 0.0f);
+  for (unsigned int i = 1; i <= workers; ++i) {
+    _workers.emplace_back(&JobSystem::work, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  _running = false;
+  _wake.notify_all();
+  for (auto &worker : _workers) {
+    worker.join();
+  }
+}
+
+JobSystem::Job JobSystem::submit(Task task, const std::vector<Job> &dependencies) {
+  Job job = allocate();
+  Record &r = record(job);
+  r.task = std::move(task);
+  r.tag = AllocTracker::currentTag();
+  r.pending = 1;    // Held until every dependency is registered
+  r.done = false;
+  r.dependents.clear();
+  ++_outstanding;
+
+  for (Job dependency : dependencies) {
+    Record &d = record(dependency);
+    std::lock_guard<std::mutex> lock(d.lock);
+    if (!d.done) {
+      d.dependents.push_back(job);
+      ++r.pending;
+    }
+  }
+
+  if (--r.pending == 0) {
+    schedule(job);
+  }
+  return job;
+}
+
+void JobSystem::wait(Job job) {
+  while (!record(job).done) {
+    if (!runOne()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::waitAll() {
+  while (_outstanding > 0) {
+    if (!runOne()) {
+      std::this_thread::yield();
+    }
+  }
+  std::lock_guard<std::mutex> lock(_recordsLock);
+  _count = 0;
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &body) {
+  grain = grain == 0 ? 1 : grain;
+  if (count <= grain || _workers.empty()) {
+    body(0, count);
+    return;
+  }
+
+  std::atomic<size_t> remaining((count + grain - 1) / grain);
+  for (size_t begin = 0; begin < count; begin += grain) {
+    size_t end = std::min(count, begin + grain);
+    submit([&body, &remaining, begin, end]() {
+      body(begin, end);
+      --remaining;
+    });
+  }
+  while (remaining > 0) {
+    if (!runOne()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+unsigned int JobSystem::threads() const {
+  return static_cast<unsigned int>(_queues.size());
+}
+
+unsigned int JobSystem::currentThread() {
+  return _self;
+}
+
+const std::vector<float> &JobSystem::getUtilization() const {
+  return _utilization;
+}
+
+void JobSystem::sample() {
+  auto now = std::chrono::steady_clock::now();
+  auto window = std::chrono::duration_cast<std::chrono::nanoseconds>(now - _lastSample).count();
+  if (window < 500000000) {
+    return;
+  }
+  for (size_t i = 0; i < _utilization.size(); ++i) {
+    _utilization[i] = static_cast<float>(_busy[i].exchange(0)) / window;
+  }
+  _lastSample = now;
+}
+
+JobSystem::Record &JobSystem::record(Job job) {
+  return _chunks[job / CHUNK_SIZE][job % CHUNK_SIZE];
+}
+
+JobSystem::Job JobSystem::allocate() {
+  std::lock_guard<std::mutex> lock(_recordsLock);
+  if (_count == CHUNK_SIZE * MAX_CHUNKS) {
+    throw std::runtime_error("JobSystem: too many jobs between two waitAll()");
+  }
+  if (!_chunks[_count / CHUNK_SIZE]) {
+    _chunks[_count / CHUNK_SIZE].reset(new Record[CHUNK_SIZE]);
+  }
+  return _count++;
+}
+
+void JobSystem::schedule(Job job) {
+  Queue &queue = *_queues[_self];
+  {
+    std::lock_guard<std::mutex> lock(queue.lock);
+    queue.jobs.push_back(job);
+  }
+  ++_queued;
+  _wake.notify_one();
+}
+
+bool JobSystem::runOne() {
+  Job job = -1;
+  const size_t n = _queues.size();
+
+  // Own queue from the back, others from the front
+  {
+    Queue &own = *_queues[_self];
+    std::lock_guard<std::mutex> lock(own.lock);
+    if (!own.jobs.empty()) {
+      job = own.jobs.back();
+      own.jobs.pop_back();
+    }
+  }
+  for (size_t i = 1; job < 0 && i < n; ++i) {
+    Queue &victim = *_queues[(_self + i) % n];
+    std::lock_guard<std::mutex> lock(victim.lock);
+    if (!victim.jobs.empty()) {
+      job = victim.jobs.front();
+      victim.jobs.pop_front();
+    }
+  }
+
+  if (job < 0) {
+    return false;
+  }
+  --_queued;
+  run(job);
+  return true;
+}
+
+void JobSystem::run(Job job) {
+  Record &r = record(job);
+  auto start = std::chrono::steady_clock::now();
+  {
+    ALLOC_TAG(r.tag);
+    r.task();
+  }
+  _busy[_self] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+  std::vector<Job> dependents;
+  {
+    std::lock_guard<std::mutex> lock(r.lock);
+    r.done = true;
+    dependents.swap(r.dependents);
+  }
+  for (Job dependent : dependents) {
+    if (--record(dependent).pending == 0) {
+      schedule(dependent);
+    }
+  }
+  --_outstanding;
+}
+
+void JobSystem::work(unsigned int self) {
+  _self = self;
+  while (_running) {
+    if (!runOne()) {
+      std::unique_lock<std::mutex> lock(_sleepLock);
+      _wake.wait_for(lock, std::chrono::milliseconds(JOB_IDLE_WAIT_MS), [this]() { return !_running || _queued > 0; });
+    }
+  }
+}
@@ -0,0 +1,28 @@
+//
+//  Lod.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+
+#include "includes/Lod.hpp"
+
+int Lod::segments(int finest, int level) {
+  return std::max(finest >> level, std::min(finest, LOD_MIN_SEGMENTS));
+}
+
+int Lod::select(float size, float span, int finest, int current) {
+  auto coarsest = [&](float limit) {
+    int level = 0;
+    while (level + 1 < LOD_LEVELS && size * span / segments(finest, level + 1) <= limit) {
+      ++level;
+    }
+    return level;
+  };
+
+  int level = coarsest(LOD_MAX_EDGE);
+  if (level <= current) {
+    return level;
+  }
+  return std::max(current, coarsest(LOD_MAX_EDGE * (1.0f - LOD_HYSTERESIS)));
+}
@@ -4,22 +4,29 @@
 
 #include "includes/Pellet.hpp"
 #include "includes/Game.hpp"
+#include "includes/FrameArena.hpp"
 
-Pellet::Pellet(float t, Vector3f coordinates, Vector3f angle, float rotation, Color c) : Displayable(coordinates),
-                                                                                         Alive(5),
-                                                                                         _color(c),
-                                                                                         _startT(t),
-                                                                                         _radius(0) {
+Pellet::Pellet(float t, Vector3f coordinates, Vector3f angle, float rotation, CollisionLayer layer, Color c)
+    : Displayable(coordinates),
+      Alive(5),
+      _color(c),
+      _startT(t),
+      _radius(0) {
   _rotation = rotation;
   _angle = angle;
-  _collidables.push_back(this);
+  _handle = Game::getInstance().getComponents().create(this, layer);
+  Game::getInstance().getComponents().orientations[_handle] = Orientation::fromAngles(_angle, _rotation);
   update();
 }
 
-void Pellet::updateShape() {
-  Vertices vertices;
+Pellet::~Pellet() {
+  Game::getInstance().getComponents().destroy(_handle);
+}
 
-  std::vector<Vertex::Ptr> bottom;
+void Pellet::updateShape() {
+  // Only the triangles outlive this call
+  FrameVector<Vertex::Ptr> bottom;
+  bottom.reserve(20);
   Vector3f p;
   for (int j = 0; j < 20; j++) {
     p.y = static_cast<float>(_radius * std::cos(j * (360.0f / 20.0f) * M_PI / 180.0f));
@@ -27,23 +34,23 @@ void Pellet::updateShape() {
     p.z = static_cast<float>(_radius * std::sin(j * (360.0f / 20.0f) * M_PI / 180.0f));
     bottom.push_back(std::make_shared<Vertex>(p));
   }
-  vertices.push_back(bottom);
 
   Triangles triangles;
+  triangles.reserve(bottom.size());
   Vertex::Ptr centerBottom = std::make_shared<Vertex>(Vector3f(0.0f, 0.0f, 0.0f));
-  Vertex::Ptr bl = vertices[0][vertices[0].size() - 1];
-  Vertex::Ptr br = vertices[0][0];
+  Vertex::Ptr bl = bottom[bottom.size() - 1];
+  Vertex::Ptr br = bottom[0];
   triangles.emplace_back(bl, centerBottom, br, Triangle::computeNormal(bl->p, centerBottom->p, br->p));
-  for (int i = 0; i < vertices[0].size() - 1; ++i) {
-    bl = vertices[0][i];
-    br = vertices[0][i + 1];
+  for (int i = 0; i < bottom.size() - 1; ++i) {
+    bl = bottom[i];
+    br = bottom[i + 1];
     triangles.emplace_back(bl, centerBottom, br, Triangle::computeNormal(bl->p, centerBottom->p, br->p));
   }
-  Shape shape = Shape(triangles, _coordinates, GL_TRIANGLES, _color);
+  Shape shape = Shape(std::move(triangles), _coordinates, GL_TRIANGLES, _color);
   shape.computePerVertexNormal();
   shape.generateBoundingBox();
   _shapes.clear();
-  _shapes.emplace_back(shape);
+  _shapes.emplace_back(std::move(shape));
 }
 
 void Pellet::update() {
@@ -58,14 +65,19 @@ void Pellet::update() {
   if (_radius > 0.1f) {
     _currentHealth = 0;
   }
+  Game::getInstance().getComponents().bounds[_handle] = BoundingBox(Vector3f(0.0f, -_radius, -_radius),
+                                                                     Vector3f(0.0f, _radius, _radius));
 }
 
 void Pellet::draw() const {
+  if (!GlState::visible(Game::getInstance().getFrustum().sphere(_coordinates, _radius))) {
+    return;
+  }
   if (Game::getInstance().getShowLight()) {
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_COLOR_MATERIAL);
-    glEnable(GL_NORMALIZE);
+    GlState::enable(GL_LIGHTING);
+    GlState::enable(GL_LIGHT0);
+    GlState::enable(GL_COLOR_MATERIAL);
+    GlState::enable(GL_NORMALIZE);
 
     GLfloat specular[] = {1.0f, 0.3f, 0.5f, 1.0f};
     glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
@@ -77,7 +89,7 @@ void Pellet::draw() const {
     glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
   }
 
-  glEnable(GL_BLEND);
+  GlState::enable(GL_BLEND);
   glPushMatrix();
   GLfloat m[16];
   glMultMatrixf(_coordinates.toTranslationMatrix(m));
@@ -85,12 +97,12 @@ void Pellet::draw() const {
   glMultMatrixf((Vector3f{0.0f, 0.0f, _rotation} * (M_PI / 180.0f)).toRotationMatrix(m));
   Displayable::draw();
   glPopMatrix();
-  glDisable(GL_BLEND);
+  GlState::disable(GL_BLEND);
 
   if (Game::getInstance().getShowLight()) {
-    glDisable(GL_NORMALIZE);
-    glDisable(GL_COLOR_MATERIAL);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_LIGHTING);
+    GlState::disable(GL_NORMALIZE);
+    GlState::disable(GL_COLOR_MATERIAL);
+    GlState::disable(GL_LIGHT0);
+    GlState::disable(GL_LIGHTING);
   }
 }
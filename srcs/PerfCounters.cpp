@@ -0,0 +1,75 @@
+//
+//  PerfCounters.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+
+#include "helpers/Glut.hpp"
+#include "includes/PerfCounters.hpp"
+#include "includes/AllocTracker.hpp"
+
+PerfCounters::PerfCounters() : _current(), _last(), _frameStart(now()),
+                               _history(PERF_HISTORY, 0.0f), _head(0), _recorded(0) {}
+
+const char *PerfCounters::name(GameEntity entity) {
+  static const char *const names[GAME_ENTITIES_EOF] = {
+      "camera", "light", "island", "axes", "skybox", "boats", "waves", "stats", "ui"
+  };
+  return names[entity];
+}
+
+double PerfCounters::now() {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PerfCounters::addTime(GameEntity entity, Phase phase, double since) {
+  _current.phases[entity][phase] += static_cast<float>(now() - since);
+}
+
+void PerfCounters::endFrame() {
+  double end = now();
+  GlState::Counters &gl = GlState::counters();
+  AllocTracker::endFrame();
+
+  _current.time = static_cast<float>(end - _frameStart);
+  _current.vertices = gl.vertices;
+  _current.triangles = gl.triangles;
+  _current.stateChanges = gl.stateChanges;
+  _current.drawn = gl.drawn;
+  _current.culled = gl.culled;
+  _current.coarse = gl.coarse;
+  _current.allocations = AllocTracker::lastTotal().count;
+  _current.allocatedBytes = AllocTracker::lastTotal().bytes;
+  _last = _current;
+
+  _history[_head] = _current.time;
+  _head = (_head + 1) % _history.size();
+  _recorded = std::min(_recorded + 1, _history.size());
+
+  _current = Frame();
+  gl = GlState::Counters();
+  _frameStart = end;
+}
+
+const PerfCounters::Frame &PerfCounters::last() const {
+  return _last;
+}
+
+float PerfCounters::percentile(float percent) const {
+  if (_recorded == 0) {
+    return 0.0f;
+  }
+  history(_sorted);
+  auto nth = _sorted.begin() + static_cast<long>((_sorted.size() - 1) * percent / 100.0f);
+  std::nth_element(_sorted.begin(), nth, _sorted.end());
+  return *nth;
+}
+
+void PerfCounters::history(std::vector<float> &out) const {
+  out.clear();
+  size_t start = (_head + _history.size() - _recorded) % _history.size();
+  for (size_t i = 0; i < _recorded; ++i) {
+    out.push_back(_history[(start + i) % _history.size()]);
+  }
+}
@@ -0,0 +1,116 @@
+//
+//  Picking.cpp
+//  IslandDefense3D
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "includes/Picking.hpp"
+#include "includes/Waves.hpp"
+
+Picking::Hit Picking::pick(const Ray &ray, float far, const Heightfield *ground, const SpatialIndex &index,
+                           const Components &components) {
+  Hit hit{NOTHING, Vector3f(), far, -1};
+  float t;
+  int id;
+  if (ground != nullptr && Picking::ground(ray, hit.distance, *ground, t)) {
+    hit = {GROUND, Vector3f(), t, -1};
+  }
+  // Each test only searches up to the nearest hit so far
+  if (ocean(ray, hit.distance, t)) {
+    hit = {OCEAN, Vector3f(), t, -1};
+  }
+  if (boats(ray, hit.distance, index, components, t, id)) {
+    hit = {BOAT, Vector3f(), t, id};
+  }
+  hit.point = ray.origin + ray.direction * hit.distance;
+  return hit;
+}
+
+bool Picking::ground(const Ray &ray, float far, const Heightfield &heightfield, float &t) {
+  if (!heightfield.intersectSegment(ray.origin, ray.origin + ray.direction * far, t)) {
+    return false;
+  }
+  t *= far;
+  return true;
+}
+
+bool Picking::ocean(const Ray &ray, float far, float &t) {
+  // Only the slab the waves can reach holds the surface, under it the ray is in the water for sure
+  const Vector3f &o = ray.origin, &d = ray.direction;
+  float amplitude = Waves::amplitude();
+  float t0 = 0.0f, t1 = far;
+  if (d.y == 0.0f) {
+    if (std::fabs(o.y) > amplitude) {
+      return false;
+    }
+  } else {
+    float ta = (amplitude - o.y) / d.y, tb = (-amplitude - o.y) / d.y;
+    t0 = std::max(t0, std::min(ta, tb));
+    t1 = std::min(t1, std::max(ta, tb));
+  }
+  if (t0 > t1) {
+    return false;
+  }
+
+  auto above = [&o, &d](float at) {
+    Vector3f p = o + d * at;
+    return p.y - Waves::computeHeight(p.x, p.z);
+  };
+  float a = t0, fa = above(a);
+  if (fa <= 0.0f) {
+    t = a;
+    return true;
+  }
+  float step = PICK_OCEAN_STEP / std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+  while (a < t1) {
+    float b = std::min(a + step, t1), fb = above(b);
+    if (fb <= 0.0f) {
+      for (int k = 0; k < PICK_REFINE_STEPS; ++k) {
+        float m = (a + b) * 0.5f;
+        if (above(m) <= 0.0f) {
+          b = m;
+        } else {
+          a = m;
+        }
+      }
+      t = b;
+      return true;
+    }
+    a = b;
+  }
+  return false;
+}
+
+bool Picking::boats(const Ray &ray, float far, const SpatialIndex &index, const Components &components, float &t,
+                    int &id) {
+  // Only the cells along the ray, widened by the largest boat, are searched. The index is as old as
+  // the tick, the boxes are the live ones: their bounding sphere goes first, the slab test after
+  const Vector3f &o = ray.origin, &d = ray.direction;
+  float length2 = d.x * d.x + d.y * d.y + d.z * d.z;
+  float radius = index.reach(LAYER(BOAT_LAYER)) + PICK_INDEX_SLACK;
+  bool found = false;
+  float entry;
+  index.forEachAlongSegment(
+      o, o + d * far, radius, LAYER(BOAT_LAYER), [&](int handle, const Vector3f &, const Vector3f &) {
+        if (!(components.flags[handle] & Components::ALIVE) || components.layers[handle] != BOAT_LAYER) {
+          return;
+        }
+        const OrientedBox &box = components.boxes[handle];
+        Vector3f w = box.center - o;
+        float radius2 = box.half[0] * box.half[0] + box.half[1] * box.half[1] + box.half[2] * box.half[2];
+        float along = w.x * d.x + w.y * d.y + w.z * d.z;
+        float distance2 = w.x * w.x + w.y * w.y + w.z * w.z;
+        if (distance2 * length2 - along * along > radius2 * length2 || (along < 0.0f && distance2 > radius2)) {
+          return;
+        }
+        if (Colliders::intersect(ray, box, entry) && entry <= far) {
+          far = entry;
+          t = entry;
+          id = handle;
+          found = true;
+        }
+      });
+  return found;
+}
@@ -0,0 +1,69 @@
+//
+//  Profiler.cpp
+//  IslandDefense3D
+//
+
+#include <cstdio>
+
+#include "includes/Profiler.hpp"
+#include "includes/JobSystem.hpp"
+
+thread_local unsigned int ProfileScope::_depth = 0;
+
+Profiler::Profiler() : _epoch(std::chrono::steady_clock::now()), _rings(JobSystem::getInstance().threads()) {
+  for (Ring &ring : _rings) {
+    ring.events.reset(new Event[PROFILER_RING_SIZE]);
+  }
+}
+
+long long Profiler::now() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _epoch).count();
+}
+
+void Profiler::record(const char *name, long long begin, long long end, unsigned int depth) {
+  Ring &ring = _rings[JobSystem::currentThread()];
+  ring.events[ring.next] = {name, begin, end, depth};
+  if (++ring.next == PROFILER_RING_SIZE) {
+    ring.next = 0;
+    ring.wrapped = true;
+  }
+}
+
+bool Profiler::exportTrace(const std::string &path) const {
+  FILE *file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    perror(path.c_str());
+    return false;
+  }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool first = true;
+  for (size_t tid = 0; tid < _rings.size(); ++tid) {
+    fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+            first ? "" : ",", static_cast<int>(tid), tid == 0 ? "main" : "worker", static_cast<int>(tid));
+    first = false;
+
+    // Oldest first, Chrome nests complete events by their timestamps
+    const Ring &ring = _rings[tid];
+    size_t count = ring.wrapped ? PROFILER_RING_SIZE : ring.next;
+    size_t start = ring.wrapped ? ring.next : 0;
+    for (size_t i = 0; i < count; ++i) {
+      const Event &e = ring.events[(start + i) % PROFILER_RING_SIZE];
+      fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,"
+                    "\"args\":{\"depth\":%u}}",
+              e.name, static_cast<int>(tid), e.begin, e.end - e.begin, e.depth);
+    }
+  }
+  fprintf(file, "\n]}\n");
+  fclose(file);
+  return true;
+}
+
+ProfileScope::ProfileScope(const char *name) : _name(name), _begin(Profiler::getInstance().now()) {
+  ++_depth;
+}
+
+ProfileScope::~ProfileScope() {
+  --_depth;
+  Profiler::getInstance().record(_name, _begin, Profiler::getInstance().now(), _depth);
+}
@@ -2,31 +2,30 @@
 // Created by wilmot_g on 23/03/18.
 //
 
+#include <map>
+#include <utility>
+
 #include "helpers/Glut.hpp"
 
 #include "includes/Projectile.hpp"
 #include "includes/Game.hpp"
+#include "includes/Island.hpp"
+#include "includes/Collisions.hpp"
+#include "includes/FrameArena.hpp"
+#include "includes/Lod.hpp"
 
 #define PROJECTILE_DAMAGES 1
-
-Projectile::Projectile(float t, Vector3f coordinates, Vector3f velocity, Color c) : Displayable(coordinates),
-                                                                                    Alive(1),
-                                                                                    _color(c),
-                                                                                    _startT(t),
-                                                                                    _start(coordinates),
-                                                                                    _velocity(velocity) {
-  Triangles triangles;
-  Shape shape = Shape(triangles, _coordinates, GL_TRIANGLES, BLACK);
-  _shapes.push_back(shape);
-}
-
-void Projectile::updateShape(float radius) {
-  Vertices vertices;
-  int numSlices = 20;
-  int numSegments = 20;
+#define PROJECTILE_RADIUS 0.02f
+
+/// UV sphere around the origin
+static Triangles buildSphere(float radius, int slices) {
+  // Only the triangles outlive this call
+  FrameVector<FrameVector<Vertex::Ptr> > vertices;
+  int numSlices = slices;
+  int numSegments = slices;
   Vector3f p, n;
   for (int i = 0; i < numSlices; ++i) {
-    std::vector<Vertex::Ptr> points;
+    FrameVector<Vertex::Ptr> points;
     auto phi = static_cast<float>(i * (2.0f * M_PI / numSlices));
     for (int j = 0; j < numSegments; j++) {
       float xzRadius = fabsf(radius * cosf(phi));
@@ -43,7 +42,7 @@ void Projectile::updateShape(float radius) {
         break;
       }
     }
-    vertices.push_back(points);
+    vertices.push_back(std::move(points));
   }
 
   Triangles triangles;
@@ -64,64 +63,138 @@ void Projectile::updateShape(float radius) {
     }
   }
 
-  Shape shape = Shape(triangles, _coordinates, GL_TRIANGLES, _color);
+  return triangles;
+}
+
+/// Every shell of a size shares the same vertices, only the triangle array is copied per shell
+static const Triangles &sharedSphere(float radius, int slices) {
+  // Shells are only spawned in the serial phase, from the boats' update() and the player's input,
+  // so the cache needs no lock. Entries are never touched once inserted
+  static std::map<std::pair<float, int>, Triangles> spheres;
+  auto found = spheres.find(std::make_pair(radius, slices));
+  if (found == spheres.end()) {
+    found = spheres.emplace(std::make_pair(radius, slices), buildSphere(radius, slices)).first;
+  }
+  return found->second;
+}
+
+Projectile::Projectile(float t, Vector3f coordinates, Vector3f velocity, CollisionLayer layer, Color c)
+    : Displayable(coordinates),
+      Alive(1),
+      _color(c),
+      _lastCheck(-CHECK_COLLISIONS_EVERY / GAME_SPEED),
+      _lastPosition(coordinates),
+      _lod(0) {
+  // The spheres never change, only their position does
+  updateShape(PROJECTILE_RADIUS);
+
+  Components &components = Game::getInstance().getComponents();
+  _handle = components.create(this, layer, Components::BALLISTIC);
+  components.origins[_handle] = coordinates;
+  components.velocities[_handle] = velocity;
+  components.spawnTimes[_handle] = t;
+  components.bounds[_handle] = BoundingBox(Vector3f(-PROJECTILE_RADIUS, -PROJECTILE_RADIUS, -PROJECTILE_RADIUS),
+                                           Vector3f(PROJECTILE_RADIUS, PROJECTILE_RADIUS, PROJECTILE_RADIUS));
+}
+
+Projectile::~Projectile() {
+  Game::getInstance().getComponents().destroy(_handle);
+}
+
+void Projectile::updateShape(float radius) {
   _shapes.clear();
+  _shapes.emplace_back(sphere(radius, SPHERE_SLICES));
+  _levels.clear();
+  _levels.reserve(LOD_LEVELS - 1);
+  for (int level = 1; level < LOD_LEVELS; ++level) {
+    _levels.emplace_back();
+    _levels.back().emplace_back(sphere(radius, Lod::segments(SPHERE_SLICES, level)));
+  }
+}
+
+Shape Projectile::sphere(float radius, int slices) const {
+  Shape shape = Shape(sharedSphere(radius, slices), _coordinates, GL_TRIANGLES, _color);
   shape.generateBoundingBox();
-  _shapes.emplace_back(shape);
+  return shape;
 }
 
-void Projectile::update() {
+void Projectile::detect() {
   if (getCurrentHealth() == 0) {
     return;
   }
 
-  float t = Game::getInstance().getTime() - _startT;
-  _coordinates.x = _start.x + _velocity.x * t;
-  _coordinates.y = _start.y + _velocity.y * t + g * t * t / 2.0f;
-  _coordinates.z = _start.z + _velocity.z * t;
-  float wave = Waves::computeHeight(_coordinates.x, _coordinates.z);
-
-  updateShape(0.02f);
-
-  static auto lastCheck = -CHECK_COLLISIONS_EVERY / GAME_SPEED;
-  if (Game::getInstance().getTime() - lastCheck > CHECK_COLLISIONS_EVERY / GAME_SPEED) {
-    lastCheck = Game::getInstance().getTime();
-    auto entities = Game::getInstance().getEntities();                      //Get all entities
-    for (auto &entityBag: entities) {                                       //Get one entity
-      for (auto entity : entityBag.second->getCollidables()) {              //Get all the subentities
-        if (entity != this) {                                               //Do not collide with yourself
-          auto aliveEntity = dynamic_cast<Alive *>(entity);                 //Can it be collided with ?
+  // Position and collider were integrated by the ballistics system
+  Components &components = Game::getInstance().getComponents();
+  _coordinates = components.positions[_handle];
+
+  if (Game::getInstance().getTime() - _lastCheck > CHECK_COLLISIONS_EVERY / GAME_SPEED) {
+    _lastCheck = Game::getInstance().getTime();
+    CollisionQueue &collisions = Game::getInstance().getCollisions();
+    Capsule swept{_lastPosition, _coordinates, PROJECTILE_RADIUS};
+    _lastPosition = _coordinates;
+
+    // The terrain itself rather than its row boxes, swept so fast shells cannot skip through
+    CollisionLayer layer = components.layers[_handle];
+    if (CollisionLayers::collides(layer, ISLAND_LAYER)) {
+      for (auto entity : Game::getInstance().getCollidables(ISLAND)) {
+        auto island = dynamic_cast<Island *>(entity);
+        if (island != nullptr) {
+          const Heightfield &ground = island->getHeightfield();
+          float t;
+          if (ground.overlapsSphere(swept.to, swept.radius) || ground.intersectSegment(swept.from, swept.to, t)) {
+            collisions.emit(CollisionEvent::HIT, _handle, this, island, PROJECTILE_DAMAGES);
+            return;
+          }
+        }
+      }
+    }
+
+    // Boats and pellets, a sphere around the swept shell against every box of the layers it can touch first
+    Vector3f middle = (swept.from + swept.to) * 0.5f;
+    Vector3f half = swept.to - middle;
+    Sphere reach{middle, std::sqrt(half.x * half.x + half.y * half.y + half.z * half.z) + swept.radius};
+    for (int other = 0; other < COLLISION_LAYERS_EOF; ++other) {
+      if (!CollisionLayers::collides(layer, static_cast<CollisionLayer>(other))) {
+        continue;
+      }
+      const OrientedBoxes &targets = Game::getInstance().getTargets(static_cast<CollisionLayer>(other));
+      FrameVector<unsigned char> hits(targets.size());
+      Colliders::overlap(reach, targets, hits.data());
+      for (size_t i = 0; i < targets.size(); ++i) {
+        if (hits[i] && Colliders::overlap(targets.get(i), swept)) {
+          auto aliveEntity = dynamic_cast<Alive *>(components.renderables[targets.ids[i]]);
           if (aliveEntity != nullptr) {
-            for (auto &thisShape: _shapes) {                                //Get the shapes of the projectile
-              for (auto &enemyShape: entity->getShapes()) {                 //Get the shapes of the subentity
-                if (enemyShape.collideWith(thisShape)) {                    //Check collision
-                  aliveEntity->takeDamage(PROJECTILE_DAMAGES);              //Deal damage
-                  _isDisplayed = false;                                     //Collision, remove projectile
-                  _currentHealth = 0;
-                  return;
-                }
-              }
-            }
+            collisions.emit(CollisionEvent::HIT, _handle, this, aliveEntity, PROJECTILE_DAMAGES);
+            return;
           }
         }
       }
     }
   }
+}
 
-  if (_coordinates.y < wave || _coordinates.y > 1 ||
-      _coordinates.x < -1 || _coordinates.x > 1 ||
-      _coordinates.z < -1 || _coordinates.z > 1) {
+void Projectile::update() {
+  // Hits were applied when the collision queue was resolved
+  if (Game::getInstance().getComponents().flags[_handle] & Components::EXPIRED) {
     _currentHealth = 0;
+  }
+  if (getCurrentHealth() == 0) {
     _isDisplayed = false;
   }
 }
 
 void Projectile::draw() const {
+  const Frustum &frustum = Game::getInstance().getFrustum();
+  if (!GlState::visible(frustum.sphere(_coordinates, PROJECTILE_RADIUS))) {
+    return;
+  }
+  _lod = GlState::lod(Lod::select(frustum.screenSize(_coordinates, PROJECTILE_RADIUS), 2.0f * M_PI, SPHERE_SLICES,
+                                  _lod));
   if (Game::getInstance().getShowLight()) {
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_COLOR_MATERIAL);
-    glEnable(GL_NORMALIZE);
+    GlState::enable(GL_LIGHTING);
+    GlState::enable(GL_LIGHT0);
+    GlState::enable(GL_COLOR_MATERIAL);
+    GlState::enable(GL_NORMALIZE);
 
     GLfloat specular[] = {1.0f, 0.3f, 0.5f, 1.0f};
     glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
@@ -133,17 +206,17 @@ void Projectile::draw() const {
     glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
   }
 
-  glEnable(GL_BLEND);
+  GlState::enable(GL_BLEND);
   glPushMatrix();
   glTranslatef(_coordinates.x, _coordinates.y, _coordinates.z);
-  Displayable::draw();
+  drawShapes(_lod == 0 ? _shapes : _levels[_lod - 1]);
   glPopMatrix();
-  glDisable(GL_BLEND);
+  GlState::disable(GL_BLEND);
 
   if (Game::getInstance().getShowLight()) {
-    glDisable(GL_NORMALIZE);
-    glDisable(GL_COLOR_MATERIAL);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_LIGHTING);
+    GlState::disable(GL_NORMALIZE);
+    GlState::disable(GL_COLOR_MATERIAL);
+    GlState::disable(GL_LIGHT0);
+    GlState::disable(GL_LIGHTING);
   }
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+//
+//  Settings.cpp
+//  IslandDefense3D
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "includes/Settings.hpp"
+
+Settings Settings::current;
+
+struct Field {
+  const char *name;
+  int Settings::*integer;
+  float Settings::*real;
+};
+
+static const Field FIELDS[] = {
+    {"window_width",           &Settings::windowWidth,        nullptr},
+    {"window_height",          &Settings::windowHeight,       nullptr},
+    {"game_speed",             nullptr,                       &Settings::gameSpeed},
+    {"frame_rate",             &Settings::frameRate,          nullptr},
+    {"check_collisions_every", nullptr,                       &Settings::checkCollisionsEvery},
+    {"max_boats",              &Settings::maxBoats,           nullptr},
+    {"boats_per_generation",   &Settings::boatsPerGeneration, nullptr},
+    {"boat_generation_delta",  nullptr,                       &Settings::boatGenerationDelta},
+    {"shot_timer",             nullptr,                       &Settings::shotTimer},
+    {"defence_timer",          nullptr,                       &Settings::defenceTimer},
+    {"waves_tessellation",     &Settings::wavesTessellation,  nullptr},
+    {"sphere_slices",          &Settings::sphereSlices,       nullptr},
+    {"trajectory_step",        nullptr,                       &Settings::trajectoryStep},
+    {"bake_lighting",          &Settings::bakeLighting,       nullptr},
+    {"governor_target_ms",     nullptr,                       &Settings::governorTargetMs},
+    {"job_workers",            &Settings::jobWorkers,         nullptr},
+};
+
+struct Preset {
+  const char *name;
+  const char *values;
+};
+
+static const Preset PRESETS[] = {
+    {"low",    "max_boats=3 waves_tessellation=32"},
+    {"medium", ""},
+    {"high",   "max_boats=10 boats_per_generation=3 waves_tessellation=128"},
+    {"stress", "max_boats=64 boats_per_generation=16 boat_generation_delta=1 waves_tessellation=256"},
+};
+
+static std::string trim(const std::string &s) {
+  size_t begin = s.find_first_not_of(" \t\r");
+  size_t end = s.find_last_not_of(" \t\r");
+  return begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+}
+
+static bool assign(const std::string &assignment) {
+  size_t equal = assignment.find('=');
+  if (equal == std::string::npos) {
+    fprintf(stderr, "settings: expected key=value, got '%s'\n", assignment.c_str());
+    return false;
+  }
+  return Settings::set(trim(assignment.substr(0, equal)), trim(assignment.substr(equal + 1)));
+}
+
+bool Settings::applyPreset(const std::string &name) {
+  for (const Preset &preset : PRESETS) {
+    if (name != preset.name) {
+      continue;
+    }
+    current = Settings();
+    char values[256];
+    snprintf(values, sizeof values, "%s", preset.values);
+    for (char *token = strtok(values, " "); token; token = strtok(nullptr, " ")) {
+      assign(token);
+    }
+    return true;
+  }
+  fprintf(stderr, "settings: unknown preset '%s'\n", name.c_str());
+  return false;
+}
+
+bool Settings::set(const std::string &key, const std::string &value) {
+  for (const Field &field : FIELDS) {
+    if (key != field.name) {
+      continue;
+    }
+    char *end;
+    if (field.integer) {
+      long parsed = strtol(value.c_str(), &end, 10);
+      if (*end == '\0' && !value.empty()) {
+        current.*field.integer = static_cast<int>(parsed);
+        return true;
+      }
+    } else {
+      float parsed = strtof(value.c_str(), &end);
+      if (*end == '\0' && !value.empty()) {
+        current.*field.real = parsed;
+        return true;
+      }
+    }
+    fprintf(stderr, "settings: invalid value '%s' for %s\n", value.c_str(), key.c_str());
+    return false;
+  }
+  fprintf(stderr, "settings: unknown key '%s'\n", key.c_str());
+  return false;
+}
+
+bool Settings::loadFile(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    perror(path.c_str());
+    return false;
+  }
+  bool ok = true;
+  for (std::string line; std::getline(file, line);) {
+    line = trim(line.substr(0, line.find('#')));
+    if (!line.empty()) {
+      ok = assign(line) && ok;
+    }
+  }
+  return ok;
+}
+
+bool Settings::parseArguments(int &argc, char **argv) {
+  bool ok = true;
+  int kept = 1;
+  for (int i = 1; i < argc; ++i) {
+    bool option = !strcmp(argv[i], "--preset") || !strcmp(argv[i], "--config") || !strcmp(argv[i], "--set");
+    if (!option) {
+      argv[kept++] = argv[i];
+      continue;
+    }
+    if (i + 1 == argc) {
+      fprintf(stderr, "settings: %s needs a value\n", argv[i]);
+      return false;
+    }
+    const char *value = argv[++i];
+    if (!strcmp(argv[i - 1], "--preset")) {
+      ok = applyPreset(value) && ok;
+    } else if (!strcmp(argv[i - 1], "--config")) {
+      ok = loadFile(value) && ok;
+    } else {
+      ok = assign(value) && ok;
+    }
+  }
+  argc = kept;
+  argv[argc] = nullptr;
+  return ok;
+}
@@ -46,35 +46,31 @@ void Shape::computePerVertexNormal() {
 }
 
 void Shape::generateBoundingBox() {
-  std::vector<Vector3f> triangleParts;
+  if (_parts.empty()) {
+    return;
+  }
+
+  // One pass over the first vertex of every triangle, no copy of the points
+  Vector3f vecMin = _parts.front().v1->p;
+  Vector3f vecMax = vecMin;
   for (auto &triangle: _parts) {
-    triangleParts.emplace_back(triangle.v1->p);
+    const Vector3f &p = triangle.v1->p;
+    vecMin = Vector3f(std::min(vecMin.x, p.x), std::min(vecMin.y, p.y), std::min(vecMin.z, p.z));
+    vecMax = Vector3f(std::max(vecMax.x, p.x), std::max(vecMax.y, p.y), std::max(vecMax.z, p.z));
   }
 
-  // TODO: Remove duplicates
-
-  auto xExtremes = std::minmax_element(triangleParts.begin(), triangleParts.end(),
-                                       [](const Vector3f &lhs, const Vector3f &rhs) {
-                                         return lhs.x > rhs.x;
-                                       });
-  auto yExtremes = std::minmax_element(triangleParts.begin(), triangleParts.end(),
-                                       [](const Vector3f &lhs, const Vector3f &rhs) {
-                                         return lhs.y > rhs.y;
-                                       });
-  auto zExtremes = std::minmax_element(triangleParts.begin(), triangleParts.end(),
-                                       [](const Vector3f &lhs, const Vector3f &rhs) {
-                                         return lhs.z > rhs.z;
-                                       });
-
-  _boundingBox = BoundingBox(Vector3f(xExtremes.second->x, yExtremes.second->y, zExtremes.second->z),
-                             Vector3f(xExtremes.first->x, yExtremes.first->y, zExtremes.first->z));
+  _boundingBox = BoundingBox(vecMin, vecMax);
+}
+
+void Shape::setBoundingBox(const BoundingBox &box) {
+  _boundingBox = box;
 }
 
-bool Shape::collideWith(Shape other) const {
+bool Shape::collideWith(const Shape &other) const {
   return Shape::collideWith(other.get_boundingBox());
 }
 
-bool Shape::collideWith(BoundingBox other) const {
+bool Shape::collideWith(const BoundingBox &other) const {
 
   BoundingBox own = get_boundingBox();
 
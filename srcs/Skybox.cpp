@@ -2,120 +2,179 @@
 // Created by wilmot_g on 01/05/18.
 //
 
-#include "includes/Waves.hpp"
-#include "includes/Game.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
 #include "includes/Skybox.hpp"
 
+struct Side {
+  const char *path;
+  GLenum target;
+};
+
+// The images already follow the cubemap conventions, none needs flipping
+static const Side SIDES[6] = {
+    {"./assets/sbs.png", GL_TEXTURE_CUBE_MAP_POSITIVE_X},
+    {"./assets/sbn.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_X},
+    {"./assets/sbt.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Y},
+    {"./assets/sbb.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Y},
+    {"./assets/sbe.png", GL_TEXTURE_CUBE_MAP_POSITIVE_Z},
+    {"./assets/sbw.png", GL_TEXTURE_CUBE_MAP_NEGATIVE_Z},
+};
+
+// The box spans y from -0.8 to 1.2, directions are taken from its center
+static const GLfloat CORNERS[8][3] = {
+    {-1.0f, -0.8f, -1.0f}, {1.0f, -0.8f, -1.0f}, {-1.0f, 1.2f, -1.0f}, {1.0f, 1.2f, -1.0f},
+    {-1.0f, -0.8f, 1.0f}, {1.0f, -0.8f, 1.0f}, {-1.0f, 1.2f, 1.0f}, {1.0f, 1.2f, 1.0f},
+};
+static const GLfloat DIRECTIONS[8][3] = {
+    {-1.0f, -1.0f, -1.0f}, {1.0f, -1.0f, -1.0f}, {-1.0f, 1.0f, -1.0f}, {1.0f, 1.0f, -1.0f},
+    {-1.0f, -1.0f, 1.0f}, {1.0f, -1.0f, 1.0f}, {-1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f},
+};
+static const GLubyte QUADS[24] = {
+    1, 0, 2, 3,   // Front
+    5, 1, 3, 7,   // Left
+    4, 5, 7, 6,   // Back
+    0, 4, 6, 2,   // Right
+    2, 6, 7, 3,   // Top
+    0, 4, 5, 1,   // Bottom
+};
+
+/// Bilinear, rgba in and out
+static void resample(const unsigned char *from, int width, int height, unsigned char *to, int size) {
+  if (width == size && height == size) {
+    memcpy(to, from, static_cast<size_t>(size) * size * 4);
+    return;
+  }
+  for (int y = 0; y < size; ++y) {
+    float v = std::max(0.0f, (y + 0.5f) * height / size - 0.5f);
+    int y0 = std::min(static_cast<int>(v), height - 1), y1 = std::min(y0 + 1, height - 1);
+    float fy = v - y0;
+    for (int x = 0; x < size; ++x) {
+      float u = std::max(0.0f, (x + 0.5f) * width / size - 0.5f);
+      int x0 = std::min(static_cast<int>(u), width - 1), x1 = std::min(x0 + 1, width - 1);
+      float fx = u - x0;
+      for (int c = 0; c < 4; ++c) {
+        float top = from[(y0 * width + x0) * 4 + c] * (1 - fx) + from[(y0 * width + x1) * 4 + c] * fx;
+        float bottom = from[(y1 * width + x0) * 4 + c] * (1 - fx) + from[(y1 * width + x1) * 4 + c] * fx;
+        to[(y * size + x) * 4 + c] = static_cast<unsigned char>(top * (1 - fy) + bottom * fy + 0.5f);
+      }
+    }
+  }
+}
+
+/// Next mip level, each texel averages 2x2 of the level above
+static void halve(const unsigned char *from, int size, unsigned char *to) {
+  int half = size / 2;
+  for (int y = 0; y < half; ++y) {
+    for (int x = 0; x < half; ++x) {
+      for (int c = 0; c < 4; ++c) {
+        int sum = from[((2 * y) * size + 2 * x) * 4 + c] + from[((2 * y) * size + 2 * x + 1) * 4 + c] +
+                  from[((2 * y + 1) * size + 2 * x) * 4 + c] + from[((2 * y + 1) * size + 2 * x + 1) * 4 + c];
+        to[(y * half + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+      }
+    }
+  }
+}
+
 Skybox::Skybox() {
-  _texture[0] = TextureLoader::loadTexture("./assets/sbw.png");
-  _texture[1] = TextureLoader::loadTexture("./assets/sbs.png");
-  _texture[2] = TextureLoader::loadTexture("./assets/sbe.png");
-  _texture[3] = TextureLoader::loadTexture("./assets/sbn.png");
-  _texture[4] = TextureLoader::loadTexture("./assets/sbt.png");
-  _texture[5] = TextureLoader::loadTexture("./assets/sbb.png");
+  JobSystem &jobs = JobSystem::getInstance();
+  for (int side = 0; side < 6; ++side) {
+    _decoding.push_back(jobs.submit([this, side]() { decode(side); }));
+  }
 }
 
-void Skybox::draw() const {
-  glPushAttrib(GL_ENABLE_BIT);
-  glEnable(GL_TEXTURE_2D);
-  glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+Skybox::~Skybox() {
+  // Only left when bake() never ran, the jobs still write into the faces
+  for (JobSystem::Job job : _decoding) {
+    JobSystem::getInstance().wait(job);
+  }
+}
 
-  glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+void Skybox::decode(int side) {
+  // SOIL keeps its load flags and failure reason in globals, so faces are decoded one at a time,
+  // only the resampling and the mip chain run side by side
+  static std::mutex soil;
+  int width, height, channels;
+  unsigned char *image;
+  {
+    std::lock_guard<std::mutex> guard(soil);
+    image = SOIL_load_image(SIDES[side].path, &width, &height, &channels, SOIL_LOAD_RGBA);
+    if (!image) {
+      fprintf(stderr, "skybox: cannot decode %s: %s\n", SIDES[side].path, SOIL_last_result());
+      return;
+    }
+  }
 
-  // Render the front quad
-  glBindTexture(GL_TEXTURE_2D, _texture[0]);
-  glBegin(GL_QUADS);
-  glTexCoord2f(0, 0);
-  glVertex3f(1.0f, -0.8f, -1.0f);
-  glTexCoord2f(1, 0);
-  glVertex3f(-1.0f, -0.8f, -1.0f);
-  glTexCoord2f(1, 1);
-  glVertex3f(-1.0f, 1.2f, -1.0f);
-  glTexCoord2f(0, 1);
-  glVertex3f(1.0f, 1.2f, -1.0f);
-  glEnd();
-
-  // Render the left quad
-  glBindTexture(GL_TEXTURE_2D, _texture[1]);
-  glBegin(GL_QUADS);
-  glTexCoord2f(0, 0);
-  glVertex3f(1.0f, -0.8f, 1.0f);
-  glTexCoord2f(1, 0);
-  glVertex3f(1.0f, -0.8f, -1.0f);
-  glTexCoord2f(1, 1);
-  glVertex3f(1.0f, 1.2f, -1.0f);
-  glTexCoord2f(0, 1);
-  glVertex3f(1.0f, 1.2f, 1.0f);
-  glEnd();
-
-  // Render the back quad
-  glBindTexture(GL_TEXTURE_2D, _texture[2]);
-  glBegin(GL_QUADS);
-  glTexCoord2f(0, 0);
-  glVertex3f(-1.0f, -0.8f, 1.0f);
-  glTexCoord2f(1, 0);
-  glVertex3f(1.0f, -0.8f, 1.0f);
-  glTexCoord2f(1, 1);
-  glVertex3f(1.0f, 1.2f, 1.0f);
-  glTexCoord2f(0, 1);
-  glVertex3f(-1.0f, 1.2f, 1.0f);
-  glEnd();
-
-  // Render the right quad
-  glBindTexture(GL_TEXTURE_2D, _texture[3]);
-  glBegin(GL_QUADS);
-  glTexCoord2f(0, 0);
-  glVertex3f(-1.0f, -0.8f, -1.0f);
-  glTexCoord2f(1, 0);
-  glVertex3f(-1.0f, -0.8f, 1.0f);
-  glTexCoord2f(1, 1);
-  glVertex3f(-1.0f, 1.2f, 1.0f);
-  glTexCoord2f(0, 1);
-  glVertex3f(-1.0f, 1.2f, -1.0f);
-  glEnd();
-
-  // Render the top quad
-  glBindTexture(GL_TEXTURE_2D, _texture[4]);
-  glBegin(GL_QUADS);
-  glTexCoord2f(0, 1);
-  glVertex3f(-1.0f, 1.2f, -1.0f);
-  glTexCoord2f(0, 0);
-  glVertex3f(-1.0f, 1.2f, 1.0f);
-  glTexCoord2f(1, 0);
-  glVertex3f(1.0f, 1.2f, 1.0f);
-  glTexCoord2f(1, 1);
-  glVertex3f(1.0f, 1.2f, -1.0f);
-  glEnd();
-
-  // Render the bottom quad
-  glBindTexture(GL_TEXTURE_2D, _texture[5]);
-  glBegin(GL_QUADS);
-  glTexCoord2f(0, 0);
-  glVertex3f(-1.0f, -0.8f, -1.0f);
-  glTexCoord2f(0, 1);
-  glVertex3f(-1.0f, -0.8f, 1.0f);
-  glTexCoord2f(1, 1);
-  glVertex3f(1.0f, -0.8f, 1.0f);
-  glTexCoord2f(1, 0);
-  glVertex3f(1.0f, -0.8f, -1.0f);
-  glEnd();
-
-  glDisable(GL_TEXTURE_2D);
-  glPopAttrib();
+  size_t bytes = 0;
+  for (int size = SKYBOX_FACE_SIZE; size >= 1; size /= 2) {
+    bytes += static_cast<size_t>(size) * size * 4;
+  }
+  std::vector<unsigned char> &pixels = _faces[side].pixels;
+  pixels.resize(bytes);
+  resample(image, width, height, pixels.data(), SKYBOX_FACE_SIZE);
+  SOIL_free_image_data(image);
+
+  unsigned char *level = pixels.data();
+  for (int size = SKYBOX_FACE_SIZE; size > 1; size /= 2) {
+    unsigned char *next = level + static_cast<size_t>(size) * size * 4;
+    halve(level, size, next);
+    level = next;
+  }
+  _faces[side].loaded = true;
 }
 
-GLuint TextureLoader::loadTexture(const char *filename) {
-  GLuint tex = SOIL_load_OGL_texture(filename, SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID,
-                                     SOIL_FLAG_MIPMAPS | SOIL_FLAG_INVERT_Y);
-  if (!tex) {
-    std::cerr << "error" << std::endl;
-    return 0;
+void Skybox::bake() {
+  for (JobSystem::Job job : _decoding) {
+    JobSystem::getInstance().wait(job);
+  }
+  _decoding.clear();
+  for (const Face &face : _faces) {
+    if (!face.loaded) {
+      return;
+    }
   }
 
-  glBindTexture(GL_TEXTURE_2D, tex);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  glGenTextures(1, &_cubemap);
+  GlState::bindTexture(GL_TEXTURE_CUBE_MAP, _cubemap);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  for (int side = 0; side < 6; ++side) {
+    const unsigned char *level = _faces[side].pixels.data();
+    for (int size = SKYBOX_FACE_SIZE, mip = 0; size >= 1; size /= 2, ++mip) {
+      glTexImage2D(SIDES[side].target, mip, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, level);
+      level += static_cast<size_t>(size) * size * 4;
+    }
+    // The GL has its own copy now
+    std::vector<unsigned char>().swap(_faces[side].pixels);
+  }
+  GlState::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
 
-  return tex;
+void Skybox::draw() const {
+  if (!_cubemap) {
+    return;
+  }
+  glPushAttrib(GL_ENABLE_BIT);
+  GlState::enable(GL_TEXTURE_CUBE_MAP);
+  glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+  glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+  GlState::bindTexture(GL_TEXTURE_CUBE_MAP, _cubemap);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 0, CORNERS);
+  glTexCoordPointer(3, GL_FLOAT, 0, DIRECTIONS);
+  glDrawElements(GL_QUADS, 24, GL_UNSIGNED_BYTE, QUADS);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  GlState::disable(GL_TEXTURE_CUBE_MAP);
+  glPopAttrib();
 }
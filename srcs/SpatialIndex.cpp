@@ -0,0 +1,117 @@
+//
+//  SpatialIndex.cpp
+//  IslandDefense3D
+//
+
+#include "includes/SpatialIndex.hpp"
+
+SpatialIndex::SpatialIndex(float extent, float cellSize) : _extent(extent) {
+  _cells = std::max(1, static_cast<int>(std::ceil(2.0f * extent / cellSize)));
+  _cellSize = 2.0f * extent / _cells;
+  _starts.assign(static_cast<size_t>(_cells * _cells + 1), 0);
+  _reach.fill(0.0f);
+}
+
+void SpatialIndex::build(const Components &components) {
+  // Counting sort: cell sizes, then where each cell starts, then every item at its place
+  std::fill(_starts.begin(), _starts.end(), 0);
+  _reach.fill(0.0f);
+  _scratch.assign(components.size(), -1);
+  for (size_t i = 0; i < components.size(); ++i) {
+    if (components.flags[i] & Components::ALIVE) {
+      const Vector3f &p = components.positions[i];
+      _scratch[i] = cell(p.z) * _cells + cell(p.x);
+      ++_starts[_scratch[i] + 1];
+      const float *half = components.boxes[i].half;
+      float &reach = _reach[components.layers[i]];
+      reach = std::max(reach, std::sqrt(half[0] * half[0] + half[1] * half[1] + half[2] * half[2]));
+    }
+  }
+  for (size_t c = 1; c < _starts.size(); ++c) {
+    _starts[c] += _starts[c - 1];
+  }
+  size_t count = static_cast<size_t>(_starts.back());
+  _ids.resize(count);
+  _positions.resize(count);
+  _velocities.resize(count);
+  _layers.resize(count);
+  _next.assign(_starts.begin(), _starts.end() - 1);
+  for (size_t i = 0; i < components.size(); ++i) {
+    if (_scratch[i] >= 0) {
+      int slot = _next[_scratch[i]]++;
+      _ids[slot] = static_cast<int>(i);
+      _positions[slot] = components.positions[i];
+      _velocities[slot] = components.velocities[i];
+      _layers[slot] = components.layers[i];
+    }
+  }
+}
+
+size_t SpatialIndex::size() const {
+  return _ids.size();
+}
+
+float SpatialIndex::reach(unsigned mask) const {
+  float reach = 0.0f;
+  for (int layer = 0; layer < COLLISION_LAYERS_EOF; ++layer) {
+    if (mask & LAYER(layer)) {
+      reach = std::max(reach, _reach[layer]);
+    }
+  }
+  return reach;
+}
+
+size_t SpatialIndex::nearest(const Vector3f &position, unsigned mask, float maxDistance, int *ids, size_t k) const {
+  if (k == 0) {
+    return 0;
+  }
+  // Rings of cells around the one holding `position`, every item of ring r is at least
+  // (r - 1) cells away, so the search stops once that is further than the k-th best
+  std::vector<std::pair<float, int> > &best = _best;
+  best.clear();
+  best.reserve(k + 1);
+  float limit2 = maxDistance * maxDistance;
+  int cx = cell(position.x), cz = cell(position.z);
+  for (int ring = 0; ring < _cells; ++ring) {
+    float reach = (ring - 1) * _cellSize;
+    if (ring > 0 && (reach * reach > limit2 || (best.size() == k && reach * reach > best.back().first))) {
+      break;
+    }
+    for (int z = cz - ring; z <= cz + ring; ++z) {
+      if (z < 0 || z >= _cells) {
+        continue;
+      }
+      // Inner rows only have their two ends on the ring
+      int step = (z == cz - ring || z == cz + ring) ? 1 : std::max(1, 2 * ring);
+      for (int x = cx - ring; x <= cx + ring; x += step) {
+        if (x < 0 || x >= _cells) {
+          continue;
+        }
+        int c = z * _cells + x;
+        for (int i = _starts[c]; i < _starts[c + 1]; ++i) {
+          if (!(mask & LAYER(_layers[i]))) {
+            continue;
+          }
+          Vector3f d = _positions[i] - position;
+          float distance2 = d.x * d.x + d.y * d.y + d.z * d.z;
+          if (distance2 > limit2 || (best.size() == k && distance2 >= best.back().first)) {
+            continue;
+          }
+          auto at = std::upper_bound(best.begin(), best.end(), std::make_pair(distance2, _ids[i]));
+          best.insert(at, std::make_pair(distance2, _ids[i]));
+          if (best.size() > k) {
+            best.pop_back();
+          }
+        }
+      }
+    }
+  }
+  for (size_t i = 0; i < best.size(); ++i) {
+    ids[i] = best[i].second;
+  }
+  return best.size();
+}
+
+int SpatialIndex::cell(float coordinate) const {
+  return std::max(0, std::min(_cells - 1, static_cast<int>(std::floor((coordinate + _extent) / _cellSize))));
+}
@@ -7,21 +7,25 @@
 
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 
 #include "helpers/Glut.hpp"
 #include "includes/Stats.hpp"
 #include "includes/Game.hpp"
+#include "includes/JobSystem.hpp"
+#include "includes/PerfCounters.hpp"
+#include "includes/AllocTracker.hpp"
+#include "helpers/BitmapFont.hpp"
 
 Stats::Stats(const Color &color) : _color(color) {}
 
 void Stats::draw() const {
-  char buffer[30];
-  char *bufp;
+  char buffer[64];
   int w, h;
 
   glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
-  glDisable(GL_DEPTH_TEST);
-  glDisable(GL_LIGHTING);
+  GlState::disable(GL_DEPTH_TEST);
+  GlState::disable(GL_LIGHTING);
 
   glMatrixMode(GL_PROJECTION);
   glPushMatrix();
@@ -36,21 +40,29 @@ void Stats::draw() const {
   glLoadIdentity();
 
   auto &game = Game::getInstance();
+  glColor3f(_color.r, _color.g, _color.b);
 
   /* Frame rate */
-  glColor3f(_color.r, _color.g, _color.b);
   snprintf(buffer, sizeof buffer, "fps        : %5.0f", game.getFrameRate());
-  glRasterPos2i(static_cast<GLint>(w - 20 - 9 * strlen(buffer)), h - 20);
-  for (bufp = buffer; *bufp; bufp++) {
-    glutBitmapCharacter(GLUT_BITMAP_9_BY_15, *bufp);
-  }
+  BitmapFont::printRight(w - 20, h - 20, buffer);
 
   /* Time per frame */
-  glColor3f(_color.r, _color.g, _color.b);
   snprintf(buffer, sizeof buffer, "frame time : %3.0fms", 1.0 / game.getFrameRate() * 1000.0);
-  glRasterPos2i(static_cast<GLint>(w - 20 - 9 * strlen(buffer)), h - 40);
-  for (bufp = buffer; *bufp; bufp++) {
-    glutBitmapCharacter(GLUT_BITMAP_9_BY_15, *bufp);
+  BitmapFont::printRight(w - 20, h - 40, buffer);
+
+  /* Job system utilization, thread 0 is the main thread */
+  const std::vector<float> &utilization = JobSystem::getInstance().getUtilization();
+  for (size_t i = 0; i < utilization.size(); ++i) {
+    snprintf(buffer, sizeof buffer, "cpu %-2d     : %4.0f%%", static_cast<int>(i), utilization[i] * 100.0f);
+    BitmapFont::printRight(w - 20, static_cast<GLint>(h - 60 - 20 * i), buffer);
+  }
+
+  /* Collisions resolved during the last tick */
+  snprintf(buffer, sizeof buffer, "collisions : %5d", game.getCollisions().getTotal());
+  BitmapFont::printRight(w - 20, static_cast<GLint>(h - 60 - 20 * utilization.size()), buffer);
+
+  if (game.getShowOverlay()) {
+    drawOverlay(h);
   }
 
   glPopMatrix();
@@ -60,4 +72,78 @@ void Stats::draw() const {
   glMatrixMode(GL_MODELVIEW);
 
   glPopAttrib();
-}
\ No newline at end of file
+}
+
+void Stats::drawOverlay(int h) const {
+  char buffer[64];
+  auto &game = Game::getInstance();
+  auto &counters = PerfCounters::getInstance();
+  const PerfCounters::Frame &frame = counters.last();
+  GLint y = h - 100;
+
+  /* Frame time percentiles over the last PERF_HISTORY frames */
+  snprintf(buffer, sizeof buffer, "p50 %5.1f  p95 %5.1f  p99 %5.1f ms",
+           counters.percentile(50.0f), counters.percentile(95.0f), counters.percentile(99.0f));
+  BitmapFont::print(20, y, buffer);
+  y -= BitmapFont::LINE_HEIGHT;
+
+  /* Per entity times, prepare and detect run on the job threads */
+  BitmapFont::print(20, y, "         prep  dtct  updt  draw  allocs");
+  y -= BitmapFont::LINE_HEIGHT;
+  for (auto &entity : game.getEntities()) {
+    const float *t = frame.phases[entity.first];
+    snprintf(buffer, sizeof buffer, "%-7s %5.2f %5.2f %5.2f %5.2f  %6ld", PerfCounters::name(entity.first),
+             t[PerfCounters::PREPARE], t[PerfCounters::DETECT], t[PerfCounters::UPDATE], t[PerfCounters::DRAW],
+             AllocTracker::last(entity.first).count);
+    BitmapFont::print(20, y, buffer);
+    y -= BitmapFont::LINE_HEIGHT;
+  }
+
+  /* Live entities */
+  const Components &components = game.getComponents();
+  auto boats = std::dynamic_pointer_cast<Entities<Boat> >(game.getEntities().at(BOATS));
+  int nbBoats = boats ? boats->size() : 0;
+  int nbShells = static_cast<int>(components.count(Components::BALLISTIC));
+  snprintf(buffer, sizeof buffer, "boats %d  shells %d  pellets %d", nbBoats, nbShells,
+           static_cast<int>(components.count()) - nbBoats - nbShells);
+  BitmapFont::print(20, y, buffer);
+  y -= BitmapFont::LINE_HEIGHT;
+
+  /* Submitted geometry, GL state and heap */
+  snprintf(buffer, sizeof buffer, "verts %lu  tris %lu", frame.vertices, frame.triangles);
+  BitmapFont::print(20, y, buffer);
+  y -= BitmapFont::LINE_HEIGHT;
+  snprintf(buffer, sizeof buffer, "drawn %lu  culled %lu  coarse %lu", frame.drawn, frame.culled,
+           frame.coarse);
+  BitmapFont::print(20, y, buffer);
+  y -= BitmapFont::LINE_HEIGHT;
+  snprintf(buffer, sizeof buffer, "state changes %lu", frame.stateChanges);
+  BitmapFont::print(20, y, buffer);
+  y -= BitmapFont::LINE_HEIGHT;
+  if (AllocTracker::enabled()) {
+    snprintf(buffer, sizeof buffer, "allocs %ld (%ld KB)%s", frame.allocations, frame.allocatedBytes / 1024,
+             AllocTracker::withinBudget() ? "" : "  over budget");
+  } else {
+    snprintf(buffer, sizeof buffer, "allocs off, build with -DALLOC_TRACKING=ON");
+  }
+  BitmapFont::print(20, y, buffer);
+  y -= BitmapFont::LINE_HEIGHT;
+  if (GOVERNOR_TARGET_MS > 0.0f) {
+    snprintf(buffer, sizeof buffer, "quality level %d  work %.1f / %.1f ms", game.getGovernor().getLevel(),
+             game.getGovernor().getAverage(), GOVERNOR_TARGET_MS);
+  } else {
+    snprintf(buffer, sizeof buffer, "governor off");
+  }
+  BitmapFont::print(20, y, buffer);
+
+  /* Frame time graph, one column per frame */
+  counters.history(_history);
+  glBegin(GL_LINES);
+  for (size_t i = 0; i < _history.size(); ++i) {
+    float height = std::min(_history[i] / PERF_GRAPH_MS, 1.0f) * 60.0f;
+    GLfloat x = 20.0f + i;
+    glVertex2f(x, 20.0f);
+    glVertex2f(x, 20.0f + height);
+  }
+  glEnd();
+}
@@ -4,18 +4,25 @@
 
 #include "includes/Waves.hpp"
 #include "includes/Game.hpp"
+#include "includes/JobSystem.hpp"
+#include "includes/Profiler.hpp"
 
 float Waves::_time = 0.0f;
 float Waves::_maxHeight = 0.0f;
 
-Waves::Waves() : _tess(64), _animate(true) {
-  update();
+Waves::Waves() : _tess(WAVES_TESSELLATION), _animate(true) {
+  _worldSpace = true;
+  prepare();
 }
 
 float Waves::maxHeight() {
   return _maxHeight;
 }
 
+float Waves::amplitude() {
+  return 0.5f * (1.0f / 8.0f + 1.0f / 7.0f);
+}
+
 float Waves::sineWave(float x, float z, float w, float a, float kx, float kz) {
   kx /= w;
   kz /= w;
@@ -41,55 +48,98 @@ float Waves::computeSlope(float x, float z) {
                  sineNormal(x, z, (float) M_PI / 2.5f, 1.0f / 7.0f, 1.0f * (float) M_PI, 2.0f * (float) M_PI));
 }
 
-void Waves::update() {
+void Waves::prepare() {
+  // The keys and the governor both go through the setting, the grid only changes with it
+  bool rebuilt = false;
+  if (_tess != WAVES_TESSELLATION || _vertices.empty()) {
+    _tess = WAVES_TESSELLATION;
+    generateGrid();
+    rebuilt = true;
+  }
+  if (_animate || rebuilt) {
+    animate();
+  }
+}
+
+void Waves::generateGrid() {
   float xStep = 2.0f / _tess;
   float zStep = 2.0f / _tess;
   float xmax = 1.0;
   float zmax = 1.0;
 
-  if (_animate) {
-    _vertices.clear();
-    float z;
-    for (int i = 0; i <= _tess; ++i) {
-      z = -zmax + i * zStep;
-      std::vector<Vertex::Ptr> row;
-      for (int j = 0; j <= _tess; j++) {
-        float x = -xmax + j * xStep;
-        float dx = 1.0f;
-        float dy = computeSlope(x, z);
-        float y = computeHeight(x, z);
-        row.emplace_back(std::make_shared<Vertex>(Vector3f(x, y, z), Vector3f(-dy, dx, 0)));
-        _maxHeight = std::max(_maxHeight, y);
-      }
-      _vertices.emplace_back(row);
+  _vertices.assign(static_cast<size_t>(_tess + 1), std::vector<Vertex::Ptr>());
+  _rowHeights.assign(static_cast<size_t>(_tess + 1), 0.0f);
+  for (int i = 0; i <= _tess; ++i) {
+    float z = -zmax + i * zStep;
+    _vertices[i].reserve(static_cast<size_t>(_tess + 1));
+    for (int j = 0; j <= _tess; j++) {
+      float x = -xmax + j * xStep;
+      _vertices[i].emplace_back(std::make_shared<Vertex>(Vector3f(x, 0.0f, z), Vector3f(0.0f, 1.0f, 0.0f)));
     }
+  }
 
-    _shapes.clear();
-    for (int i = 0; i < _vertices.size() - 1; ++i) {
-      const std::vector<Vertex::Ptr> &pointRow = _vertices[i];
-      const std::vector<Vertex::Ptr> &pointUpRow = _vertices[i + 1];
+  // Square chunks rather than rows, so the ones out of view can be culled. Their bounds
+  // come from the grid and the wave amplitude, no need to walk the triangles
+  _shapes.clear();
+  for (int ci = 0; ci < _tess; ci += WAVES_CHUNK_CELLS) {
+    for (int cj = 0; cj < _tess; cj += WAVES_CHUNK_CELLS) {
+      int endI = std::min(ci + WAVES_CHUNK_CELLS, _tess), endJ = std::min(cj + WAVES_CHUNK_CELLS, _tess);
       std::vector<Triangle> parts;
-      for (int j = 0; j < pointRow.size() - 1; j++) {
-        const Vertex::Ptr p1 = pointRow[j];
-        const Vertex::Ptr p2 = pointRow[j + 1];
-        const Vertex::Ptr p3 = pointUpRow[j];
-        const Vertex::Ptr p4 = pointUpRow[j + 1];
-
-        parts.emplace_back(p1, p2, p3);
-        parts.emplace_back(p3, p2, p4);
+      parts.reserve(static_cast<size_t>(2 * (endI - ci) * (endJ - cj)));
+      for (int i = ci; i < endI; ++i) {
+        const std::vector<Vertex::Ptr> &pointRow = _vertices[i];
+        const std::vector<Vertex::Ptr> &pointUpRow = _vertices[i + 1];
+        for (int j = cj; j < endJ; j++) {
+          const Vertex::Ptr p1 = pointRow[j];
+          const Vertex::Ptr p2 = pointRow[j + 1];
+          const Vertex::Ptr p3 = pointUpRow[j];
+          const Vertex::Ptr p4 = pointUpRow[j + 1];
+
+          parts.emplace_back(p1, p2, p3);
+          parts.emplace_back(p3, p2, p4);
+        }
       }
-      _shapes.emplace_back(parts, GL_TRIANGLES, Color(0.0f, 0.5f, 1.0f, 0.8f));
+      _shapes.emplace_back(std::move(parts), GL_TRIANGLES, Color(0.0f, 0.5f, 1.0f, 0.8f));
+      _shapes.back().setBoundingBox(BoundingBox(Vector3f(-xmax + cj * xStep, -amplitude(), -zmax + ci * zStep),
+                                                Vector3f(-xmax + endJ * xStep, amplitude(), -zmax + endI * zStep)));
     }
+  }
+}
+
+void Waves::animate() {
+  PROFILE_SCOPE("Waves::animate");
+  // The triangles share these vertices, moving them in place moves the chunks without a single allocation
+  JobSystem::getInstance().parallelFor(_vertices.size(), JOB_GRAIN, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      _rowHeights[i] = _maxHeight;
+      for (const Vertex::Ptr &vertex : _vertices[i]) {
+        float x = vertex->p.x, z = vertex->p.z;
+        float dx = 1.0f;
+        float dy = computeSlope(x, z);
+        vertex->p.y = computeHeight(x, z);
+        vertex->n = Vector3f(-dy, dx, 0);
+        _rowHeights[i] = std::max(_rowHeights[i], vertex->p.y);
+      }
+    }
+  });
+  for (float height : _rowHeights) {
+    _maxHeight = std::max(_maxHeight, height);
+  }
+}
+
+void Waves::update() {
+  // Boats and shells read the surface during prepare(), time only moves here
+  if (_animate) {
     _time += Game::getInstance().getDeltaTime();
   }
 }
 
 void Waves::draw() const {
   if (Game::getInstance().getShowLight()) {
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_NORMALIZE);
-    glEnable(GL_COLOR_MATERIAL);
+    GlState::enable(GL_LIGHTING);
+    GlState::enable(GL_LIGHT0);
+    GlState::enable(GL_NORMALIZE);
+    GlState::enable(GL_COLOR_MATERIAL);
 
     GLfloat specular[] = {0.7f, 0.7f, 0.9f, 1.0f};
     glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
@@ -101,14 +151,14 @@ void Waves::draw() const {
     glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
   }
 
-  glEnable(GL_BLEND);
+  GlState::enable(GL_BLEND);
   Displayable::draw();
   if (Game::getInstance().getShowTangeant()) {
     glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
-    glDisable(GL_COLOR_MATERIAL);
-    glDisable(GL_BLEND);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_LIGHTING);
+    GlState::disable(GL_COLOR_MATERIAL);
+    GlState::disable(GL_BLEND);
+    GlState::disable(GL_LIGHT0);
+    GlState::disable(GL_LIGHTING);
     glBegin(GL_LINES);
     for (const Shape &row : _shapes) {
       for (const Triangle &t : row._parts) {
@@ -128,13 +178,13 @@ void Waves::draw() const {
     }
     glEnd();
   }
-  glDisable(GL_BLEND);
+  GlState::disable(GL_BLEND);
 
   if (Game::getInstance().getShowLight()) {
-    glDisable(GL_COLOR_MATERIAL);
-    glDisable(GL_NORMALIZE);
-    glDisable(GL_LIGHT0);
-    glDisable(GL_LIGHTING);
+    GlState::disable(GL_COLOR_MATERIAL);
+    GlState::disable(GL_NORMALIZE);
+    GlState::disable(GL_LIGHT0);
+    GlState::disable(GL_LIGHTING);
   }
 }
 
@@ -143,12 +193,9 @@ void Waves::toggleAnimation() {
 }
 
 void Waves::doubleVertices() {
-  Waves::_tess *= 2;
-  _vertices.clear();
+  Settings::current.wavesTessellation = _tess * 2;
 }
 
 void Waves::halveSegments() {
-  Waves::_tess /= 2;
-  Waves::_tess = _tess < 4 ? 4 : _tess;
-  _vertices.clear();
+  Settings::current.wavesTessellation = _tess / 2 < 4 ? 4 : _tess / 2;
 }
@@ -24,6 +24,10 @@ public:
     return _currentHealth = newHealth < 0 ? 0 : newHealth;
   }
 
+  void kill() {
+    _currentHealth = 0;
+  }
+
   int getCurrentHealth() {
     return _currentHealth;
   }
@@ -0,0 +1,45 @@
+//
+//  BitmapFont.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <cstring>
+#include "Glut.hpp"
+
+/// GLUT_BITMAP_9_BY_15 baked into one display list per printable character,
+/// a whole line is then drawn with a single glCallLists.
+class BitmapFont {
+public:
+  static const int CHAR_WIDTH = 9;
+  static const int LINE_HEIGHT = 20;
+
+  static void print(GLint x, GLint y, const char *text) {
+    static GLuint base = build();
+    glRasterPos2i(x, y);
+    glPushAttrib(GL_LIST_BIT);
+    glListBase(base - FIRST);
+    glCallLists(static_cast<GLsizei>(strlen(text)), GL_UNSIGNED_BYTE, text);
+    glPopAttrib();
+  }
+
+  /// Right aligned on `right`
+  static void printRight(GLint right, GLint y, const char *text) {
+    print(right - CHAR_WIDTH * static_cast<GLint>(strlen(text)), y, text);
+  }
+
+private:
+  static const int FIRST = 32;
+  static const int COUNT = 95;
+
+  static GLuint build() {
+    GLuint base = glGenLists(COUNT);
+    for (int i = 0; i < COUNT; ++i) {
+      glNewList(base + i, GL_COMPILE);
+      glutBitmapCharacter(GLUT_BITMAP_9_BY_15, FIRST + i);
+      glEndList();
+    }
+    return base;
+  }
+};
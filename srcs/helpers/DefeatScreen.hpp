@@ -22,8 +22,8 @@ public:
     int w, h;
 
     glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_LIGHTING);
+    GlState::disable(GL_DEPTH_TEST);
+    GlState::disable(GL_LIGHTING);
 
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
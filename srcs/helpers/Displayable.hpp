@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "Entity.hpp"
 #include "Color.hpp"
 #include "../includes/Shape.hpp"
@@ -25,16 +26,35 @@ public:
 
   virtual void draw() const;
 
+  /// Runs concurrently with the other entities' prepare(), must only touch the entity's own state
+  virtual void prepare() {};
+
+  /// Runs concurrently after every prepare(), reads the other entities and reports collisions to the queue
+  virtual void detect() {};
+
+  /// Runs on the main thread once collisions are resolved, in entity order
   virtual void update() {};
 
+  /// Compiles the geometry that never changes, called once at load when there is a GL context
+  virtual void bake() {};
+
   const Shapes &getShapes() const;
 
   bool isDisplayed() const;
 
-  virtual const std::list<Displayable *> &getCollidables();
+  /// Appends the entities that can be hit, the caller owns and reuses the vector
+  virtual void getCollidables(std::vector<Displayable *> &collidables);
 
 protected:
-  std::list<Displayable *> _collidables;
+  /// What draw() does with `_shapes`, for entities that pick among several meshes.
+  /// `lit` replays the lists with baked lighting where there are some
+  void drawShapes(const Shapes &shapes, bool lit = false) const;
+
+  /// Records every shape into a display list, plus one shaded for a point light at `light` when given.
+  /// False when GL ran out of lists, the shapes left are then drawn vertex by vertex
+  static bool compile(Shapes &shapes, const Vector3f *light = nullptr);
+
   Shapes _shapes = Shapes();
   bool _isDisplayed = true;
+  bool _worldSpace = false;   // Shapes are drawn untransformed, so draw() can cull them one by one
 };
\ No newline at end of file
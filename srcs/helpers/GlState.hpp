@@ -0,0 +1,60 @@
+//
+//  GlState.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include "Glut.hpp"
+
+/// Counting wrappers around the GL calls the performance overlay reports on.
+/// Only called from the main thread, the counters are reset every frame.
+class GlState {
+public:
+  struct Counters {
+    unsigned long vertices;
+    unsigned long triangles;
+    unsigned long stateChanges;
+    unsigned long drawn, culled;      // Shapes and instances that went through a frustum test
+    unsigned long coarse;             // Instances drawn with one of their coarser meshes
+  };
+
+  static Counters &counters() {
+    static Counters counters = {};
+    return counters;
+  }
+
+  static void enable(GLenum capability) {
+    ++counters().stateChanges;
+    glEnable(capability);
+  }
+
+  static void disable(GLenum capability) {
+    ++counters().stateChanges;
+    glDisable(capability);
+  }
+
+  static void bindTexture(GLenum target, GLuint texture) {
+    ++counters().stateChanges;
+    glBindTexture(target, texture);
+  }
+
+  static void submitted(unsigned long triangles) {
+    counters().triangles += triangles;
+    counters().vertices += triangles * 3;
+  }
+
+  /// Counts one frustum test, returns `visible`
+  static bool visible(bool visible) {
+    ++(visible ? counters().drawn : counters().culled);
+    return visible;
+  }
+
+  /// Counts one instance drawn at a level of detail, returns `level`
+  static int lod(int level) {
+    if (level > 0) {
+      ++counters().coarse;
+    }
+    return level;
+  }
+};
@@ -16,4 +16,6 @@
 #   include <GL/glut.h>
 #   include <GL/gl.h>
 
-#endif
\ No newline at end of file
+#endif
+
+#include "GlState.hpp"
\ No newline at end of file
@@ -22,20 +22,20 @@ static int hash[] = {208, 34, 231, 213, 32, 248, 233, 56, 161, 78, 24, 140, 71,
                      255, 114, 20, 218, 113, 154, 27, 127, 246, 250, 1, 8, 198, 250, 209, 92, 222, 173, 21, 88, 102,
                      219};
 
-int noise2(int x, int y) {
+inline int noise2(int x, int y) {
   int tmp = hash[(y + SEED) % 256];
   return hash[(tmp + x) % 256];
 }
 
-float lin_inter(float x, float y, float s) {
+inline float lin_inter(float x, float y, float s) {
   return x + s * (y - x);
 }
 
-float smooth_inter(float x, float y, float s) {
+inline float smooth_inter(float x, float y, float s) {
   return lin_inter(x, y, s * s * (3 - 2 * s));
 }
 
-float noise2d(float x, float y) {
+inline float noise2d(float x, float y) {
   auto x_int = static_cast<int>(x);
   auto y_int = static_cast<int>(y);
   float x_frac = x - x_int;
@@ -49,7 +49,7 @@ float noise2d(float x, float y) {
   return smooth_inter(low, high, y_frac);
 }
 
-float perlin2d(float x, float y, float freq, int depth) {
+inline float perlin2d(float x, float y, float freq, int depth) {
   float xa = x * freq;
   float ya = y * freq;
   float amp = 1.0f;
@@ -0,0 +1,74 @@
+//
+//  Pool.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Fixed-capacity storage for objects of type T.
+/// Objects are constructed in place in slots reserved up front and released
+/// slots go back to a free list, so acquiring and releasing never touches the
+/// heap. Addresses stay stable for the lifetime of an object.
+template<class T>
+class Pool {
+public:
+  explicit Pool(size_t capacity) : _storage(capacity), _live(capacity, false) {
+    _free.reserve(capacity);
+    for (size_t i = capacity; i > 0; --i) {
+      _free.push_back(i - 1);
+    }
+  }
+
+  ~Pool() {
+    for (size_t i = 0; i < _storage.size(); ++i) {
+      if (_live[i]) {
+        reinterpret_cast<T *>(&_storage[i])->~T();
+      }
+    }
+  }
+
+  Pool(const Pool &) = delete;
+
+  Pool &operator=(const Pool &) = delete;
+
+  /// Returns nullptr when the pool is exhausted
+  template<class... Args>
+  T *acquire(Args &&... args) {
+    if (_free.empty()) {
+      return nullptr;
+    }
+    size_t slot = _free.back();
+    _free.pop_back();
+    T *object = new(&_storage[slot]) T(std::forward<Args>(args)...);
+    _live[slot] = true;
+    return object;
+  }
+
+  void release(T *object) {
+    auto slot = static_cast<size_t>(reinterpret_cast<Slot *>(object) - _storage.data());
+    object->~T();
+    _live[slot] = false;
+    _free.push_back(slot);
+  }
+
+  size_t capacity() const {
+    return _storage.size();
+  }
+
+  size_t size() const {
+    return _storage.size() - _free.size();
+  }
+
+private:
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+  std::vector<Slot> _storage;
+  std::vector<size_t> _free;
+  std::vector<bool> _live;
+};
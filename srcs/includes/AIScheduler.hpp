@@ -0,0 +1,63 @@
+//
+//  AIScheduler.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <vector>
+
+/// Hands out think slots to AI agents.
+/// Every agent thinks at its own interval, offset by a per-agent phase so that
+/// agents spawned together do not all think on the same tick, and stretched
+/// with the distance to the island (AI LOD). A per-tick budget caps the cost
+/// of a burst of agents becoming due at once; denied agents stay due.
+/// Grants are decided in beginTick(), scanning the tickets from where the last
+/// grant stopped, so an agent left out waits at most ceil(agents / budget)
+/// ticks. shouldThink() is then safe to call concurrently for different
+/// tickets and the outcome is deterministic.
+class AIScheduler {
+public:
+  typedef int Ticket;
+
+  AIScheduler();
+
+  void beginTick(float now);
+
+  Ticket enroll(float now);
+
+  void release(Ticket ticket);
+
+  /// On success `elapsed` receives the time since the agent's previous think
+  bool shouldThink(Ticket ticket, float now, float distance, float &elapsed);
+
+  int thinksThisTick() const;
+
+  /// Enrolled agents
+  int agents() const;
+
+  /// Ticks the agent waiting the longest has been left out of the budget, as of this tick
+  int longestWait() const;
+
+  /// Probability that an event happening `rate` times per second occurs in `dt` seconds
+  static float chance(float rate, float dt);
+
+private:
+  struct Slot {
+    float nextThink;
+    float lastThink;
+    bool used;
+    bool granted;
+    int waited;             // Ticks due without a grant
+  };
+
+  float interval(float distance) const;
+
+  std::vector<Slot> _slots;
+  std::vector<Ticket> _free;
+  int _enrolled;
+  int _thinks;
+  int _agents;
+  int _longestWait;
+  size_t _cursor;           // First slot the next tick's scan looks at
+};
@@ -0,0 +1,81 @@
+//
+//  AllocTracker.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "Config.hpp"
+
+/// Heap allocation tracker, only hooked into operator new when built with
+/// -DALLOC_TRACKING=ON. Every allocation is counted in the calling thread's
+/// row under the current tag, a GameEntity while that entity runs and
+/// UNTAGGED otherwise. Jobs inherit the tag of the thread that submitted them.
+/// endFrame() must run on the main thread between two ticks.
+class AllocTracker {
+public:
+  static const int UNTAGGED = GAME_ENTITIES_EOF;
+  static const int TAGS = GAME_ENTITIES_EOF + 1;
+
+  struct Counter {
+    long count;
+    long bytes;
+  };
+
+  static bool enabled();
+
+  static void record(size_t bytes);
+
+  static int currentTag();
+
+  static void setTag(int tag);
+
+  /// Publishes the counters of the frame that just ended and resets them
+  static void endFrame();
+
+  /// Last frame, one counter per tag
+  static const Counter &last(int tag);
+
+  static Counter lastTotal();
+
+  /// Whether the last frame stayed under ALLOC_FRAME_BUDGET allocations
+  static bool withinBudget();
+
+private:
+  static const int MAX_THREADS = 64;
+
+  struct alignas(64) Row {
+    std::atomic<long> count[TAGS];
+    std::atomic<long> bytes[TAGS];
+  };
+
+  static Row _rows[MAX_THREADS];
+  static Counter _last[TAGS];
+  static thread_local int _tag;
+};
+
+/// Tags the allocations of its own lifetime
+class AllocScope {
+public:
+  explicit AllocScope(int tag) : _previous(AllocTracker::currentTag()) {
+    AllocTracker::setTag(tag);
+  }
+
+  ~AllocScope() {
+    AllocTracker::setTag(_previous);
+  }
+
+private:
+  int _previous;
+};
+
+#ifdef ALLOC_TRACKING
+# define ALLOC_CONCAT_(a, b) a##b
+# define ALLOC_CONCAT(a, b) ALLOC_CONCAT_(a, b)
+# define ALLOC_TAG(tag) AllocScope ALLOC_CONCAT(_allocScope, __LINE__)(tag)
+#else
+# define ALLOC_TAG(tag)
+#endif
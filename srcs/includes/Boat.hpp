@@ -7,27 +7,51 @@
 
 #pragma once
 
+#include <random>
 #include "../helpers/Movable.hpp"
 #include "Cannon.hpp"
+#include "AIScheduler.hpp"
+#include "Components.hpp"
 
 class Boat : public Movable, public Alive {
 public:
 
   explicit Boat(Color color, Vector3f startPos);
 
+  ~Boat();
+
   void draw() const override;
 
+  void prepare() override;
+
+  void detect() override;
+
   void update() override;
 
   Cannon::Ptr getCannon() const;
 
-  const std::list<Displayable *> &getCollidables() override;
+  void getCollidables(std::vector<Displayable *> &collidables) override;
 
 private:
 
   void computeAI(const Vector3f &);
 
+  void steer(const Vector3f &islandPos);
+
+  void think(float elapsed);
+
+  /// A player shell is heading this way, read from the spatial index built at the start of this tick
+  bool threatened() const;
+
+  void checkCollisions();
+
   Cannon::Ptr _cannon;
   float _duration;
+  float _lastCollisionCheck;
+  Vector3f _look;
+  bool _wantsBlast, _wantsDefend;
+  AIScheduler::Ticket _ticket;
+  Components::Handle _handle;
+  std::mt19937 _random;
 };
 
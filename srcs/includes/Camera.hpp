@@ -11,6 +11,8 @@
 #include "../helpers/Glut.hpp"
 #include "../helpers/Movable.hpp"
 #include "../helpers/Displayable.hpp"
+#include "Colliders.hpp"
+#include "Frustum.hpp"
 
 class Camera : public Movable {
 private:
@@ -40,5 +42,11 @@ public:
   Vector3f getCoordinates();
 
   std::pair<float, float> getRotation();
+
+  /// World ray through a point of the screen, x and y from -1 to 1 with y up
+  Ray ray(float x, float y, float aspect = 1.0f) const;
+
+  /// What draw() lets through the projection set up in Game::draw()
+  Frustum frustum(float aspect = 1.0f) const;
 };
 
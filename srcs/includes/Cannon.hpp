@@ -16,7 +16,8 @@ class Cannon : public Displayable {
 public:
   typedef std::shared_ptr<Cannon> Ptr;
 
-  explicit Cannon(float speed = 3.0f, float radius = 0.01, Color color = Color(0, 127, 255));
+  explicit Cannon(float speed = 3.0f, float radius = 0.01, Color color = Color(0, 127, 255),
+                  CollisionLayer shells = PLAYER_SHELL_LAYER, CollisionLayer shields = PLAYER_SHIELD_LAYER);
 
   void draw() const override;
 
@@ -30,6 +31,14 @@ public:
 
   void setAngle(Vector3f angle);
 
+  /// Turns and raises the barrel so shells land on `target` at the current speed, on the low arc.
+  /// Out of reach targets get the longest shot in their direction and false is returned.
+  bool aimAt(const Vector3f &target);
+
+  void prepare() override;
+
+  void detect() override;
+
   void update() override;
 
   void speed(float value);
@@ -40,17 +49,22 @@ public:
 
   void defend();
 
-  const std::list<Displayable *> &getCollidables() override;
+  void getCollidables(std::vector<Displayable *> &collidables) override;
 
 private:
+  void drawBarrel() const;
+
   void drawTrajectory() const;
 
+  Color _color;
+  CollisionLayer _shells, _shields;
   float _speed;
   float _radius;
   float _rotation;
   Vector3f _velocity;
   float _lastFire, _lastDefence;
-  Color _color;
   Entities<Projectile> _projectiles;
   Entities<Pellet> _defences;
+  std::vector<Shapes> _levels;    // Coarser barrels, _levels[k] is level k + 1
+  mutable int _lod;               // Level drawn last frame
 };
\ No newline at end of file
@@ -0,0 +1,117 @@
+//
+//  Colliders.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <vector>
+
+#include "Shape.hpp"
+
+/// Rotation part of an entity's world transform, the world directions of its local axes
+struct Orientation {
+  Orientation();
+
+  /// Euler angles in degrees then a turn around z, composed like the entities' draw()
+  static Orientation fromAngles(const Vector3f &angle, float rotation = 0.0f);
+
+  Vector3f axes[3];
+};
+
+/// Local box carried by an orientation and a position
+struct OrientedBox {
+  OrientedBox();
+
+  OrientedBox(const BoundingBox &local, const Vector3f &position, const Orientation &orientation);
+
+  /// Smallest world aligned box around this one
+  BoundingBox bounds() const;
+
+  Vector3f center;
+  Vector3f axes[3];
+  float half[3];
+};
+
+struct Sphere {
+  Vector3f center;
+  float radius;
+};
+
+/// Sphere swept from `from` to `to`
+struct Capsule {
+  Vector3f from, to;
+  float radius;
+};
+
+/// Points at origin + direction * t for t >= 0
+struct Ray {
+  Vector3f origin, direction;
+};
+
+/// Oriented boxes one float array per field, so batch tests load four boxes at once
+struct OrientedBoxes {
+  enum Field {
+    CX, CY, CZ,
+    UX, UY, UZ,
+    VX, VY, VZ,
+    WX, WY, WZ,
+    HU, HV, HW,
+    FIELD_EOF
+  };
+
+  void clear();
+
+  void push(const OrientedBox &box, int id);
+
+  size_t size() const;
+
+  OrientedBox get(size_t i) const;
+
+  std::vector<float> fields[FIELD_EOF];
+  std::vector<int> ids;             // Whatever the caller needs to find the owner back
+};
+
+/// World aligned boxes one float array per bound, the table the broad loops test against
+struct AlignedBoxes {
+  enum Field {
+    MIN_X, MIN_Y, MIN_Z,
+    MAX_X, MAX_Y, MAX_Z,
+    FIELD_EOF
+  };
+
+  void clear();
+
+  void push(const BoundingBox &box, int id);
+
+  size_t size() const;
+
+  std::vector<float> fields[FIELD_EOF];
+  std::vector<int> ids;
+};
+
+/// Overlap tests between the collider primitives.
+/// Box pairs go through the separating axis theorem, the 15 axes being both
+/// boxes' faces and the cross products of their edges.
+class Colliders {
+public:
+  static bool overlap(const OrientedBox &a, const OrientedBox &b);
+
+  static bool overlap(const OrientedBox &box, const Sphere &sphere);
+
+  /// Rounded edges of the swept volume are treated as square, so this errs towards a hit
+  static bool overlap(const OrientedBox &box, const Capsule &capsule);
+
+  static bool overlap(const Sphere &a, const Sphere &b);
+
+  static bool overlap(const Capsule &capsule, const Sphere &sphere);
+
+  /// Nearest entry of the ray into the box, `t` is 0 when it starts inside
+  static bool intersect(const Ray &ray, const OrientedBox &box, float &t);
+
+  /// One sphere against every box, four boxes per instruction with SSE, `hits` gets one byte per box
+  static void overlap(const Sphere &sphere, const OrientedBoxes &boxes, unsigned char *hits);
+
+  /// Same as Shape::collideWith against every box, touching faces do not count
+  static void overlap(const BoundingBox &box, const AlignedBoxes &boxes, unsigned char *hits);
+};
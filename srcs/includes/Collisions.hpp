@@ -0,0 +1,59 @@
+//
+//  Collisions.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <vector>
+
+#include "../helpers/Alive.hpp"
+#include "Config.hpp"
+
+/// Filter run before any geometry, from the masks in Config.hpp
+class CollisionLayers {
+public:
+  static unsigned mask(CollisionLayer layer);
+
+  /// Both layers have to list each other
+  static bool collides(CollisionLayer a, CollisionLayer b);
+};
+
+struct CollisionEvent {
+  enum Type {
+    HIT,        // A shell hit something alive
+    CRASH,      // A boat crashed into the island
+    RAM,        // A boat ran into another boat
+    TYPE_EOF
+  };
+
+  Type type;
+  int key;        // Orders the events of a tick, the source's component handle
+  Alive *source;  // Dies when the event is applied
+  Alive *target;
+  int damage;
+};
+
+/// Collisions found during the detection phase, resolved in one batch.
+/// Detection may run on any job thread, each one appends to its own buffer.
+/// resolve() merges them in a fixed order so the outcome does not depend on
+/// thread timing, skipping events whose source already died this tick.
+class CollisionQueue {
+public:
+  CollisionQueue();
+
+  void emit(CollisionEvent::Type type, int key, Alive *source, Alive *target, int damage);
+
+  /// Applies damage and kills the sources, returns the number of events applied
+  int resolve();
+
+  /// Events applied by the last resolve()
+  int getCount(CollisionEvent::Type type) const;
+
+  int getTotal() const;
+
+private:
+  std::vector<std::vector<CollisionEvent> > _buffers;
+  std::vector<CollisionEvent> _merged;
+  int _counts[CollisionEvent::TYPE_EOF];
+};
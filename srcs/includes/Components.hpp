@@ -0,0 +1,71 @@
+//
+//  Components.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "../helpers/Displayable.hpp"
+#include "Shape.hpp"
+#include "Colliders.hpp"
+#include "Config.hpp"
+
+/// Component storage for the dynamic entities (boats, projectiles, pellets).
+/// Every component lives in its own contiguous array indexed by a handle, so
+/// systems walk them linearly instead of chasing shared_ptrs through the
+/// entity hierarchy. Entities keep their classes and only hold a handle.
+class Components {
+public:
+  typedef int Handle;
+
+  enum Flag : unsigned char {
+    NONE = 0,
+    ALIVE = 1 << 0,       // Slot in use
+    BALLISTIC = 1 << 1,   // Position driven by the ballistics system
+    EXPIRED = 1 << 2      // Left the play area, the owner should die
+  };
+
+  Handle create(Displayable *owner, CollisionLayer layer, unsigned char flags = ALIVE);
+
+  void destroy(Handle handle);
+
+  /// Number of slots systems have to walk, free slots included
+  size_t size() const;
+
+  size_t count() const;
+
+  /// Slots in use with every bit of `flags` set
+  size_t count(unsigned char flags) const;
+
+  std::vector<Vector3f> positions;
+  std::vector<Vector3f> velocities;
+  std::vector<Vector3f> origins;          // Ballistic launch point
+  std::vector<float> spawnTimes;
+  std::vector<BoundingBox> bounds;        // Local space
+  std::vector<Orientation> orientations;  // Set by the owner when it turns, identity otherwise
+  std::vector<OrientedBox> boxes;         // World space, refreshed by Systems::colliders
+  std::vector<BoundingBox> colliders;     // World aligned around boxes, refreshed by Systems::colliders
+  std::vector<Displayable *> renderables;
+  std::vector<CollisionLayer> layers;
+  std::vector<unsigned char> flags;
+
+private:
+  std::vector<Handle> _free;
+};
+
+class Systems {
+public:
+  /// Moves ballistic components along their parabola and flags the ones leaving the play area
+  static void ballistics(Components &components, float time, size_t begin, size_t end);
+
+  /// Carries local bounds by orientations and positions
+  static void colliders(Components &components, size_t begin, size_t end);
+
+  /// Boxes of the live components that are not shells, one table per layer, ids being their handles,
+  /// and the world aligned boxes around them in the same order
+  static void targets(const Components &components, std::array<OrientedBoxes, COLLISION_LAYERS_EOF> &targets,
+                      std::array<AlignedBoxes, COLLISION_LAYERS_EOF> &bounds);
+};
@@ -7,31 +7,98 @@
 
 #pragma once
 
+#include "Settings.hpp"
+
 // GENERAL
 #define MILLI 1000.0f
 
 // GAME
 #define GAME_NAME "Island Defense 3D"
-#define GAME_WIDTH 600
-#define GAME_HEIGHT 600
-#define GAME_SPEED 2
+#define GAME_WIDTH (Settings::current.windowWidth)
+#define GAME_HEIGHT (Settings::current.windowHeight)
+#define GAME_SPEED (Settings::current.gameSpeed)
+#define FRAME_RATE (Settings::current.frameRate)
+
+// PACING
+#define PACER_SWAP_SMOOTHING 0.1f // Weight of the newest swap in the average
+#define PACER_VSYNC_ON 0.4f       // Average swap over this fraction of a frame means vsync...
+#define PACER_VSYNC_OFF 0.1f      // ...and under this one it is gone
 
 // COLLISIONS
-#define CHECK_COLLISIONS_EVERY 0.04f
+#define CHECK_COLLISIONS_EVERY (Settings::current.checkCollisionsEvery)
+#define LAYER(layer) (1u << (layer))
+// What each layer may touch, a pair is only tested when both sides list each other
+#define PLAYER_SHELL_MASK (LAYER(BOAT_LAYER) | LAYER(ISLAND_LAYER) | LAYER(ENEMY_SHIELD_LAYER))
+#define ENEMY_SHELL_MASK (LAYER(BOAT_LAYER) | LAYER(ISLAND_LAYER) | LAYER(PLAYER_SHIELD_LAYER))
+#define BOAT_MASK (LAYER(PLAYER_SHELL_LAYER) | LAYER(ENEMY_SHELL_LAYER) | LAYER(BOAT_LAYER) | LAYER(ISLAND_LAYER) \
+                   | LAYER(PLAYER_SHIELD_LAYER))
+#define ISLAND_MASK (LAYER(PLAYER_SHELL_LAYER) | LAYER(ENEMY_SHELL_LAYER) | LAYER(BOAT_LAYER))
+#define PLAYER_SHIELD_MASK (LAYER(ENEMY_SHELL_LAYER) | LAYER(BOAT_LAYER))
+#define ENEMY_SHIELD_MASK (LAYER(PLAYER_SHELL_LAYER))
 
 // CAMERA
 #define CAMERA_TRANSLATION_SPEED 1.0f
 #define CAMERA_ROTATION_SPEED 0.01f
 #define CAMERA_X_ROT_START 30.0f
 #define CAMERA_Y_ROT_START (-245.0f)
+#define CAMERA_FOV 75.0f          // Vertical, degrees
+#define CAMERA_NEAR 0.01f
+#define CAMERA_FAR 3.0f
+
+// PICKING
+#define PICK_OCEAN_STEP 0.01f     // Ray march step over the waves, world units
+#define PICK_REFINE_STEPS 8       // Bisections once the surface is crossed
+#define PICK_INDEX_SLACK 0.01f    // Boats move less than this between two builds of the spatial index
 
 // BOATS
 #define BOAT_SPEED 0.005f
-#define BOAT_GEN_DELTA 5
-#define NBR_BOATS_PER_GEN 2
+#define BOAT_GEN_DELTA (Settings::current.boatGenerationDelta)
+#define NBR_BOATS_PER_GEN (Settings::current.boatsPerGeneration)
 #define BOATS_BASE_HEALTH 1
-#define MAX_BOATS 5
+#define MAX_BOATS (Settings::current.maxBoats)
 #define KAMIKAZE 5
+#define BOAT_FIRE_RATE 3.0f       // Attempts per second
+#define BOAT_CULL_RADIUS 0.07f    // Around the hull
+
+// AI
+#define AI_THINK_INTERVAL 0.1f
+#define AI_MAX_THINKS_PER_TICK 8
+#define AI_LOD_NEAR 0.4f          // Full think rate under this distance to the island
+#define AI_LOD_FAR 0.9f           // Slowest think rate over this distance
+#define AI_LOD_MAX_SCALE 4.0f
+
+// NAVIGATION
+#define FLOW_FIELD_RESOLUTION 64
+#define BOAT_SEPARATION_RADIUS 0.12f
+#define BOAT_SEPARATION_WEIGHT 0.5f
+
+// TARGETING
+#define SPATIAL_CELL_SIZE 0.1f    // Side of the spatial index cells
+#define AIM_ASSIST_RADIUS 0.08f   // A boat this close to the picked point gets the shot instead
+#define BOAT_THREAT_RANGE 0.4f    // Boats defend against player shells this close...
+#define BOAT_THREAT_ANGLE 30.0f   // ...coming from this many degrees around the island's direction
+
+// WAVES
+#define WAVES_TESSELLATION (Settings::current.wavesTessellation)
+#define WAVES_CHUNK_CELLS 8       // Side of the culled ocean chunks, in grid cells
+
+// MESHES
+#define SPHERE_SLICES (Settings::current.sphereSlices)
+#define TRAJECTORY_STEP (Settings::current.trajectoryStep)
+#define BAKE_LIGHTING (Settings::current.bakeLighting)
+
+// SKYBOX
+#define SKYBOX_FACE_SIZE 512      // Cubemap faces must be square and alike, the images are resampled to this
+
+// LIGHT
+#define LIGHT_AMBIENT 0.2f        // GL's default scene ambient
+#define LIGHT_DIFFUSE 0.7f
+
+// LOD
+#define LOD_LEVELS 3              // Finest included, every level halves the segments of the one before
+#define LOD_MIN_SEGMENTS 6
+#define LOD_MAX_EDGE 0.02f        // Edges may span this fraction of half the screen height...
+#define LOD_HYSTERESIS 0.25f      // ...and must shrink this much further under it before going coarser
 
 // ISLAND
 #define ISLAND_BASE_HEALTH 50
@@ -41,8 +108,47 @@
 #define DEC_SPEED  (-INC_SPEED)
 #define INC_ROTATION  (static_cast<float>(0.05f * 180.0f / M_PI))
 #define DEC_ROTATION  (-INC_ROTATION)
-#define SHOT_TIMER 1.0f
-#define DEFENCE_TIMER 5.0f
+#define SHOT_TIMER (Settings::current.shotTimer)
+#define DEFENCE_TIMER (Settings::current.defenceTimer)
+
+// JOBS
+#define JOB_WORKERS (Settings::current.jobWorkers)
+#define JOB_GRAIN 8               // Items per job in parallel loops
+#define JOB_IDLE_WAIT_MS 10       // Idle workers poll this often on top of being notified, the main thread helps meanwhile
+
+// POOLS
+#define PROJECTILE_POOL_SIZE 16   // Per cannon
+#define PELLET_POOL_SIZE 4        // Per cannon
+
+// PROFILING
+#define PROFILER_RING_SIZE 65536  // Scopes kept per thread, the oldest are overwritten
+#define PROFILER_TRACE_FILE "trace.json"
+
+// OVERLAY
+#define FRAME_RATE_INTERVAL 0.5f  // Seconds between two fps refreshes
+#define PERF_HISTORY 240          // Frames kept for the percentiles and the graph
+#define PERF_GRAPH_MS 50.0f       // Frame time at the top of the graph
+
+// ALLOCATIONS
+#define ALLOC_BASE_BUDGET 256     // Heap allocations allowed in a steady state frame...
+#define ALLOC_BOAT_BUDGET 20      // ...plus this many for each boat a generation may spawn
+#define ALLOC_FRAME_BUDGET (ALLOC_BASE_BUDGET + ALLOC_BOAT_BUDGET * NBR_BOATS_PER_GEN)
+
+// ARENA
+#define FRAME_ARENA_BLOCK_SIZE (256 * 1024)   // Bytes, per thread
+
+// GOVERNOR
+#define GOVERNOR_TARGET_MS (Settings::current.governorTargetMs)
+#define GOVERNOR_SMOOTHING 0.1f           // Weight of the newest frame in the average
+#define GOVERNOR_LOWER_ABOVE 1.1f         // Quality drops over this fraction of the target...
+#define GOVERNOR_RAISE_BELOW 0.6f         // ...and comes back under this one
+#define GOVERNOR_HOLD 1.0f                // Seconds out of bounds before stepping
+#define GOVERNOR_COOLDOWN 2.0f            // Seconds between two steps
+#define GOVERNOR_MIN_TESSELLATION 16
+#define GOVERNOR_MIN_SPHERE_SLICES 8
+#define GOVERNOR_MAX_TRAJECTORY_STEP 0.04f
+#define GOVERNOR_MIN_BOATS 2
+#define GOVERNOR_MAX_CHECK_COLLISIONS_EVERY 0.12f
 
 // COLORS
 #define BLACK   Color(0, 0, 0)
@@ -64,4 +170,15 @@ enum GameEntity {
   STATS,
   UI,                 // SHOULD STAY AT THE END
   GAME_ENTITIES_EOF
-};
\ No newline at end of file
+};
+
+// COLLISION LAYERS
+enum CollisionLayer {
+  PLAYER_SHELL_LAYER,   // Fired by the island's cannon
+  ENEMY_SHELL_LAYER,    // Fired by the boats
+  BOAT_LAYER,
+  ISLAND_LAYER,
+  PLAYER_SHIELD_LAYER,  // The island's pellets
+  ENEMY_SHIELD_LAYER,   // The boats' pellets
+  COLLISION_LAYERS_EOF
+};
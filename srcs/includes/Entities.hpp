@@ -5,13 +5,22 @@
 #pragma once
 
 #include "../helpers/Displayable.hpp"
+#include "../helpers/Pool.hpp"
+#include "JobSystem.hpp"
 
 template<class T>
 class Entities : public Displayable, public Alive {
 public:
 
-  explicit Entities() : Alive(1) {
+  explicit Entities(size_t capacity) : Alive(1), _pool(capacity) {
     isAlive = std::is_base_of<Alive, T>::value;
+    _entities.reserve(capacity);
+  }
+
+  ~Entities() {
+    for (auto e : _entities) {
+      _pool.release(e);
+    }
   }
 
   void draw() const override {
@@ -20,19 +29,43 @@ public:
     }
   }
 
-  void add(const std::shared_ptr<T> entity) {
+  /// Constructs a new entity in the pool, returns nullptr when it is full
+  template<class... Args>
+  T *spawn(Args &&... args) {
+    T *entity = _pool.acquire(std::forward<Args>(args)...);
     if (entity) {
       _entities.push_back(entity);
     }
+    return entity;
+  }
+
+  void prepare() override {
+    JobSystem::getInstance().parallelFor(_entities.size(), JOB_GRAIN, [this](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        _entities[i]->prepare();
+      }
+    });
+  }
+
+  void detect() override {
+    JobSystem::getInstance().parallelFor(_entities.size(), JOB_GRAIN, [this](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        _entities[i]->detect();
+      }
+    });
   }
 
   void update() override {
-    for (auto it = _entities.begin(); it != _entities.end();) {
-      it->get()->update();
-      if (!it->get()->isDisplayed() || (isAlive && it->get()->getCurrentHealth() == 0)) {
-        it = _entities.erase(it);
+    for (size_t i = 0; i < _entities.size();) {
+      T *entity = _entities[i];
+      entity->update();
+      if (!entity->isDisplayed() || (isAlive && entity->getCurrentHealth() == 0)) {
+        // Swap and pop, the moved entity is updated on the next iteration
+        _pool.release(entity);
+        _entities[i] = _entities.back();
+        _entities.pop_back();
       } else {
-        ++it;
+        ++i;
       }
     }
   }
@@ -41,15 +74,18 @@ public:
     return static_cast<int>(_entities.size());
   }
 
-  const std::list<Displayable *> &getCollidables() override {
-    _collidables.clear();
-    for (auto entityBag : _entities) {
-      _collidables.push_back(entityBag.get());
+  int capacity() const {
+    return static_cast<int>(_pool.capacity());
+  }
+
+  void getCollidables(std::vector<Displayable *> &collidables) override {
+    for (auto entity : _entities) {
+      collidables.push_back(entity);
     }
-    return _collidables;
   }
 
 private:
-  std::vector<std::shared_ptr<T> > _entities;
+  Pool<T> _pool;
+  std::vector<T *> _entities;
   bool isAlive;
 };
@@ -0,0 +1,85 @@
+//
+//  FlowField.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../helpers/Displayable.hpp"
+#include "Shape.hpp"
+
+/// Grid over the sea holding, for every cell, the direction of the shortest
+/// path to the goal around obstacles. Boats sample it instead of steering
+/// straight at the island. The grid also buckets boats by position every tick
+/// so separation and boat-vs-boat checks only look at the surrounding cells.
+/// Occupant positions are snapshotted when bucketed, so boats moving during
+/// the parallel update phase read a consistent picture.
+class FlowField {
+public:
+  explicit FlowField(int resolution = FLOW_FIELD_RESOLUTION, float extent = 1.0f);
+
+  ~FlowField();
+
+  FlowField(const FlowField &) = delete;
+
+  FlowField &operator=(const FlowField &) = delete;
+
+  void build(const BoundingBox &goal, const std::vector<BoundingBox> &obstacles);
+
+  /// Builds on a worker thread, direction() is only valid once isReady()
+  void buildAsync(const BoundingBox &goal, const std::vector<BoundingBox> &obstacles);
+
+  bool isReady() const;
+
+  /// Unit vector on the xz plane pointing along the path to the goal
+  Vector3f direction(const Vector3f &position) const;
+
+  void clearOccupants();
+
+  void addOccupant(Displayable *occupant);
+
+  /// Push away from the occupants closer than `radius`
+  Vector3f separation(const Displayable *self, float radius) const;
+
+  /// Calls `visitor(occupant, position)` on the occupants of the cells around `position` until it returns true
+  template<class F>
+  bool forEachNeighbour(const Vector3f &position, F visitor) const {
+    int cx = bucket(position.x);
+    int cz = bucket(position.z);
+    for (int z = std::max(0, cz - 1); z <= std::min(_buckets - 1, cz + 1); ++z) {
+      for (int x = std::max(0, cx - 1); x <= std::min(_buckets - 1, cx + 1); ++x) {
+        for (const Occupant &occupant : _occupants[z * _buckets + x]) {
+          if (visitor(occupant.entity, occupant.position)) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+private:
+  struct Occupant {
+    Displayable *entity;
+    Vector3f position;
+  };
+
+  int bucket(float coordinate) const;
+
+  float center(int cell) const;
+
+  int _resolution;
+  float _extent;
+  float _cellSize;
+  std::vector<float> _dx, _dz;
+  std::atomic<bool> _ready;
+  std::thread _worker;
+
+  int _buckets;
+  float _bucketSize;
+  std::vector<std::vector<Occupant> > _occupants;
+};
@@ -0,0 +1,92 @@
+//
+//  FrameArena.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Config.hpp"
+
+/// Bump allocator for data that does not outlive a tick.
+/// Every thread allocates from its own arena, so allocating is a pointer bump
+/// with no lock. Memory is never given back individually: resetAll() rewinds
+/// every arena at the end of Game::update, blocks are kept for the next tick.
+/// Nothing allocated here may be kept across ticks.
+class FrameArena {
+public:
+  /// Arena of the calling thread
+  static FrameArena &local();
+
+  /// Main thread only, while no job is running
+  static void resetAll();
+
+  FrameArena();
+
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  void *allocate(size_t bytes, size_t alignment);
+
+  void reset();
+
+  /// Bytes handed out since the last reset
+  size_t used() const;
+
+private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  std::vector<Block> _blocks;
+  size_t _block, _offset, _used;
+
+  static std::mutex _registryLock;
+  static std::vector<FrameArena *> _registry;
+};
+
+/// STL allocator drawing from the arena of the thread that created it
+template<class T>
+class ArenaAllocator {
+public:
+  typedef T value_type;
+
+  ArenaAllocator() : _arena(&FrameArena::local()) {}
+
+  template<class U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : _arena(other.arena()) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *, size_t) {}
+
+  FrameArena *arena() const {
+    return _arena;
+  }
+
+  template<class U>
+  bool operator==(const ArenaAllocator<U> &other) const {
+    return _arena == other.arena();
+  }
+
+  template<class U>
+  bool operator!=(const ArenaAllocator<U> &other) const {
+    return _arena != other.arena();
+  }
+
+private:
+  FrameArena *_arena;
+};
+
+template<class T>
+using FrameVector = std::vector<T, ArenaAllocator<T> >;
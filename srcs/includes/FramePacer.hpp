@@ -0,0 +1,35 @@
+//
+//  FramePacer.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <chrono>
+
+#include "Config.hpp"
+
+/// Holds the main loop to FRAME_RATE frames per second.
+/// wait() sleeps until the next deadline instead of spinning, and drops the
+/// missed deadlines when a frame runs long rather than bursting to catch up.
+/// Swaps that block mean vsync already paces the loop, the pacer then stands
+/// aside so the two do not stack up into half the refresh rate.
+class FramePacer {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  FramePacer();
+
+  /// Sleeps until the next frame is due, returns at once when late or unpaced
+  void wait();
+
+  /// Milliseconds the last buffer swap blocked
+  void swapped(double ms);
+
+  bool getVsync() const;
+
+private:
+  Clock::time_point _deadline;
+  double _swap;             // Average swap time, milliseconds
+  bool _vsync;
+};
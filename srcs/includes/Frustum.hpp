@@ -0,0 +1,40 @@
+//
+//  Frustum.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include "Shape.hpp"
+
+/// Volume the camera sees, as six planes facing inwards.
+/// Tests are conservative: a volume is only rejected when it lies entirely
+/// behind one plane, so near the corners a few invisible ones get through.
+class Frustum {
+public:
+  /// Sees everything, until the first frame sets the real one
+  Frustum();
+
+  /// `corners` are the directions through the screen corners in order around the screen,
+  /// `forward` the direction through its middle, `focal` one over the tangent of half the vertical fov
+  Frustum(const Vector3f &eye, const Vector3f corners[4], const Vector3f &forward, float near, float far,
+          float focal);
+
+  bool sphere(const Vector3f &center, float radius) const;
+
+  bool box(const BoundingBox &box) const;
+
+  /// Projected radius of the sphere over half the screen height, huge until the first frame
+  float screenSize(const Vector3f &center, float radius) const;
+
+private:
+  struct Plane {
+    Vector3f normal;
+    float offset;     // Inside when dot(normal, p) + offset >= 0
+  };
+
+  Plane _planes[6];
+  int _count;
+  Vector3f _eye;
+  float _near, _focal;
+};
@@ -14,6 +14,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <array>
 
 #include "../helpers/Glut.hpp"
 #include "../helpers/Displayable.hpp"
@@ -22,6 +23,14 @@
 #include "Config.hpp"
 #include "Waves.hpp"
 #include "Boat.hpp"
+#include "AIScheduler.hpp"
+#include "FlowField.hpp"
+#include "Components.hpp"
+#include "SpatialIndex.hpp"
+#include "Frustum.hpp"
+#include "Collisions.hpp"
+#include "Governor.hpp"
+#include "FramePacer.hpp"
 
 class Game {
 
@@ -38,6 +47,12 @@ public:
 
   int start(int argc, char **argv);
 
+  /// Creates the entities without a window, time then only moves through tick()
+  void startHeadless();
+
+  /// Advances the headless clock by `seconds` and runs one update
+  void tick(float seconds);
+
   void draw();
 
   void keyboard(unsigned char key, int x, int y) const;
@@ -60,21 +75,67 @@ public:
 
   const bool getShowLight() const;
 
+  const bool getShowOverlay() const;
+
   const EntityList &getEntities() const;
 
+  AIScheduler &getScheduler();
+
+  FlowField &getFlowField();
+
+  Components &getComponents();
+
+  CollisionQueue &getCollisions();
+
+  /// Boxes of the boats and pellets on a layer, gathered once colliders are refreshed
+  const OrientedBoxes &getTargets(CollisionLayer layer) const;
+
+  /// World aligned boxes around getTargets(layer), in the same order
+  const AlignedBoxes &getTargetBounds(CollisionLayer layer) const;
+
+  /// View volume of the frame being drawn
+  const Frustum &getFrustum() const;
+
+  /// Live components by position, rebuilt before prepare() from where the last tick left them
+  const SpatialIndex &getSpatialIndex() const;
+
+  const Governor &getGovernor() const;
+
+  /// Collidables of one entity, snapshotted at the start of the tick
+  const std::vector<Displayable *> &getCollidables(GameEntity entity) const;
+
+  /// Collidables of every entity, snapshotted at the start of the tick
+  const std::vector<Displayable *> &getCollidables() const;
+
   Game(const Game &) = delete;
 
   Game &operator=(const Game &) = delete;
 
 private:
   KeyboardMap _keyboardMap;
+  AIScheduler _scheduler;   // Declared before the entities, boats release their ticket on destruction
+  FlowField _flowField;
+  Components _components;
+  CollisionQueue _collisions;
   EntityList _entities;
+  std::array<std::vector<Displayable *>, GAME_ENTITIES_EOF> _collidables;
+  std::vector<Displayable *> _allCollidables;
+  std::array<OrientedBoxes, COLLISION_LAYERS_EOF> _targets;
+  std::array<AlignedBoxes, COLLISION_LAYERS_EOF> _targetBounds;
+  SpatialIndex _spatial;
+  Frustum _frustum;
+  Governor _governor;
+  FramePacer _pacer;
+  float _updateWork = 0.0f, _drawWork = 0.0f;   // Milliseconds spent in the last update and draw, swap excluded
   float _time, _lastTime, _deltaTime = 0.0;
   float _lastFrameRateT, _frameRateInterval, _frameRate, _frames;
   bool _showWireframe = false;
   bool _showTangeant = false;
   bool _showNormal = false;
   bool _showLight = true;
+  bool _showOverlay = false;
+  bool _headless = false;
+  float _clock = 0.0f;
 
   void initDrawCallback() const;
 
@@ -94,6 +155,8 @@ private:
 
   void updateTime();
 
+  void snapshotCollidables();
+
   static void idleFunc();
 
   // Helpers
@@ -141,7 +204,7 @@ private:
   }
 
   // Singleton
-  Game() : _frameRateInterval(0), _time(0), _lastTime(0), _lastFrameRateT(0), _frameRate(0), _frames(0) {}
+  Game() : _frameRateInterval(FRAME_RATE_INTERVAL), _time(0), _lastTime(0), _lastFrameRateT(0), _frameRate(0), _frames(0) {}
 
   ~Game() = default;
 
@@ -0,0 +1,59 @@
+//
+//  Governor.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include "Config.hpp"
+
+/// Trades visual and simulation quality for frame time.
+/// Fed with the update and draw work of every frame, it steps down one rung of
+/// a fixed ladder while the average stays over GOVERNOR_TARGET_MS, and back up
+/// once there is headroom again. The knobs live in Settings::current, the
+/// values found there on the first frame are the best quality it restores.
+/// A knob changed later on, by the keys, is the player's choice: the ladder
+/// only caps it, the lower quality of the two is what gets applied.
+class Governor {
+public:
+  Governor();
+
+  /// `time` in seconds, `workMs` the update and draw time of the last frame
+  void update(float time, float workMs);
+
+  /// 0 is full quality
+  int getLevel() const;
+
+  float getAverage() const;
+
+private:
+  struct Knobs {
+    int tessellation;
+    int sphereSlices;
+    float trajectoryStep;
+    int maxBoats;
+    float checkCollisionsEvery;
+  };
+
+  Knobs knobs(int level) const;
+
+  /// The player's values capped by the ladder at `level`
+  Knobs effective(int level) const;
+
+  /// Takes the knobs that changed since the last write as the player's, true if any did
+  bool adopt();
+
+  void write(const Knobs &knobs);
+
+  void apply(int level);
+
+  bool _started;
+  Knobs _best;
+  Knobs _player;            // What the settings and the keys asked for
+  Knobs _applied;           // Last written to Settings::current
+  int _level;
+  float _average;
+  float _overSince;         // Start of the current run over the target, -1 when not over
+  float _underSince;        // Start of the current run with headroom, -1 when not under
+  float _lastStep;
+};
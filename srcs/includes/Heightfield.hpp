@@ -0,0 +1,61 @@
+//
+//  Heightfield.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <vector>
+
+#include "../helpers/Vector3f.hpp"
+
+/// Regular grid of heights with a min/max pyramid on top.
+/// Cells are split along the same diagonal as the island mesh, so queries
+/// see exactly the drawn surface. Every pyramid level halves the grid and
+/// keeps the lowest and highest height below each node, which lets queries
+/// skip whole quadrants and only reach the few cells they actually touch.
+/// Anything inside the footprint and under the surface is solid.
+class Heightfield {
+public:
+  Heightfield();
+
+  /// `heights` holds (resolution + 1)^2 samples, row by row along z, `step` apart from `origin` in x and z
+  Heightfield(const Vector3f &origin, float step, int resolution, std::vector<float> heights);
+
+  bool contains(float x, float z) const;
+
+  /// Surface height, only meaningful inside the footprint
+  float height(float x, float z) const;
+
+  float maxHeight() const;
+
+  /// First point of the segment inside the ground, `t` goes from 0 at `from` to 1 at `to`
+  bool intersectSegment(const Vector3f &from, const Vector3f &to, float &t) const;
+
+  bool overlapsSphere(const Vector3f &center, float radius) const;
+
+private:
+  struct Level {
+    int size;
+    std::vector<float> min, max;
+  };
+
+  float sample(int i, int j) const;
+
+  float cellHeight(int i, int j, float fx, float fz) const;
+
+  bool segmentNode(int level, int i, int j, const Vector3f &from, const Vector3f &delta, float t0, float t1,
+                   float &t) const;
+
+  bool segmentCell(int i, int j, const Vector3f &from, const Vector3f &delta, float t0, float t1, float &t) const;
+
+  bool sphereNode(int level, int i, int j, const Vector3f &center, float radius) const;
+
+  bool sphereCell(int i, int j, const Vector3f &center, float radius) const;
+
+  Vector3f _origin;
+  float _step;
+  int _resolution;
+  std::vector<float> _heights;
+  std::vector<Level> _levels;       // Cells first, a single node last
+};
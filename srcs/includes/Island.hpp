@@ -8,6 +8,7 @@
 #include <iostream>
 #include "../helpers/Displayable.hpp"
 #include "Cannon.hpp"
+#include "Heightfield.hpp"
 
 class Island : public Displayable, public Alive {
 public:
@@ -15,11 +16,20 @@ public:
 
   void draw() const override;
 
+  void bake() override;
+
+  void prepare() override;
+
+  void detect() override;
+
   void update() override;
 
   Cannon::Ptr getCannon() const;
 
-  const std::list<Displayable *> &getCollidables() override;
+  /// The top surface, what shells and boats collide with
+  const Heightfield &getHeightfield() const;
+
+  void getCollidables(std::vector<Displayable *> &collidables) override;
 
 private:
 
@@ -27,7 +37,14 @@ private:
 
   void generateTopTriangles(Color color);
 
+  /// Row shapes over one vertex out of `step` in each direction
+  void generateRows(int step, Color color, Shapes &shapes) const;
+
   float _zmax, _xmax, _tess, _maxHeight, _minHeight;
   Vertices _vertices;
+  Heightfield _ground;
   Cannon::Ptr _cannon;
+  std::vector<Shapes> _levels;    // Coarser surfaces, _levels[k] is level k + 1
+  mutable int _lod;               // Level drawn last frame
+  bool _bakedLight;               // The lists carry the lighting, GL's is left off
 };
\ No newline at end of file
@@ -0,0 +1,112 @@
+//
+//  JobSystem.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Config.hpp"
+
+/// Work-stealing thread pool.
+/// Every thread owns a queue: it pops its own jobs from the back and steals
+/// from the front of the others when it runs dry. The main thread is thread 0
+/// and runs jobs while it waits. Jobs may depend on other jobs, a job is only
+/// queued once all its dependencies are done.
+/// Handles are recycled by waitAll(), which must be called from the main thread.
+class JobSystem {
+public:
+  typedef int Job;
+  typedef std::function<void()> Task;
+
+  static JobSystem &getInstance() {
+    static JobSystem instance(JOB_WORKERS);
+    return instance;
+  }
+
+  /// 0 workers means one per core, minus the main thread
+  explicit JobSystem(unsigned int workers);
+
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  Job submit(Task task, const std::vector<Job> &dependencies = std::vector<Job>());
+
+  void wait(Job job);
+
+  void waitAll();
+
+  /// Splits [0, count) in chunks of `grain` items and waits for all of them
+  void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &body);
+
+  unsigned int threads() const;
+
+  /// Index of the calling thread, 0 on the main thread
+  static unsigned int currentThread();
+
+  /// Share of the last sampling window each thread spent running jobs, thread 0 is the main thread
+  const std::vector<float> &getUtilization() const;
+
+  void sample();
+
+private:
+  struct Record {
+    Task task;
+    int tag;        // Allocation tag of the submitter
+    std::atomic<int> pending;
+    std::atomic<bool> done;
+    std::mutex lock;
+    std::vector<Job> dependents;
+  };
+
+  struct Queue {
+    std::mutex lock;
+    std::deque<Job> jobs;
+  };
+
+  static const int CHUNK_SIZE = 256;
+  static const int MAX_CHUNKS = 256;
+
+  Record &record(Job job);
+
+  Job allocate();
+
+  void schedule(Job job);
+
+  bool runOne();
+
+  void run(Job job);
+
+  void work(unsigned int self);
+
+  static thread_local unsigned int _self;
+
+  std::array<std::unique_ptr<Record[]>, MAX_CHUNKS> _chunks;
+  std::mutex _recordsLock;
+  int _count;
+
+  std::vector<std::unique_ptr<Queue> > _queues;
+  std::vector<std::thread> _workers;
+  std::atomic<bool> _running;
+  std::atomic<int> _queued;
+  std::atomic<int> _outstanding;
+  std::mutex _sleepLock;
+  std::condition_variable _wake;
+
+  std::unique_ptr<std::atomic<long long>[]> _busy;
+  std::vector<float> _utilization;
+  std::chrono::steady_clock::time_point _lastSample;
+};
@@ -0,0 +1,23 @@
+//
+//  Lod.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include "Config.hpp"
+
+/// Picks one of LOD_LEVELS precomputed meshes from how large an object looks.
+/// A level is fine enough while its edges span less than LOD_MAX_EDGE of the screen,
+/// the coarsest such level is drawn. Going finer is immediate, going coarser waits
+/// until the edges are LOD_HYSTERESIS under the limit, so an object sitting on a
+/// boundary does not flicker between two meshes.
+class Lod {
+public:
+  /// Segments around a round mesh at `level`, halved per level down to LOD_MIN_SEGMENTS
+  static int segments(int finest, int level);
+
+  /// `size` comes from Frustum::screenSize, `span` is an edge times the segments over the radius,
+  /// 2 pi around a sphere, `current` the level drawn last frame
+  static int select(float size, float span, int finest, int current);
+};
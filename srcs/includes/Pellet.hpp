@@ -6,13 +6,16 @@
 
 #include "../helpers/Axes.hpp"
 #include "../helpers/Alive.hpp"
+#include "Components.hpp"
 
 class Pellet : public Displayable, public Alive {
 public:
   //Typedef
   typedef std::shared_ptr<Pellet> Ptr;
 
-  explicit Pellet(float, Vector3f, Vector3f, float, Color c = Color(255, 0, 0));
+  explicit Pellet(float, Vector3f, Vector3f, float, CollisionLayer, Color c = Color(255, 0, 0));
+
+  ~Pellet();
 
   void updateShape();
 
@@ -25,4 +28,5 @@ private:
   Color _color;
   float _startT;
   float _rotation;
+  Components::Handle _handle;
 };
\ No newline at end of file
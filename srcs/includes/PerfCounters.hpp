@@ -0,0 +1,69 @@
+//
+//  PerfCounters.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "Config.hpp"
+
+/// Per-frame measurements shown by the performance overlay.
+/// Times are accumulated during a frame and published by endFrame(), the
+/// overlay always shows the last complete frame.
+class PerfCounters {
+public:
+  enum Phase {
+    PREPARE,
+    DETECT,
+    UPDATE,
+    DRAW,
+    PHASE_EOF
+  };
+
+  struct Frame {
+    float time;                                           // Milliseconds since the previous frame
+    float phases[GAME_ENTITIES_EOF][PHASE_EOF];           // Milliseconds
+    unsigned long vertices, triangles, stateChanges;
+    unsigned long drawn, culled, coarse;
+    long allocations, allocatedBytes;                     // Only counted with ALLOC_TRACKING
+  };
+
+  static PerfCounters &getInstance() {
+    static PerfCounters instance;
+    return instance;
+  }
+
+  static const char *name(GameEntity entity);
+
+  /// Milliseconds on a monotonic clock
+  static double now();
+
+  /// Each (entity, phase) slot must only be written by one thread at a time
+  void addTime(GameEntity entity, Phase phase, double since);
+
+  void endFrame();
+
+  const Frame &last() const;
+
+  /// Frame time under which `percent` of the recorded frames fall
+  float percentile(float percent) const;
+
+  /// Frame times, oldest first
+  void history(std::vector<float> &out) const;
+
+  PerfCounters(const PerfCounters &) = delete;
+
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+private:
+  PerfCounters();
+
+  Frame _current, _last;
+  double _frameStart;
+  std::vector<float> _history;
+  size_t _head, _recorded;
+  mutable std::vector<float> _sorted;
+};
@@ -0,0 +1,46 @@
+//
+//  Picking.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include "Heightfield.hpp"
+#include "Colliders.hpp"
+#include "SpatialIndex.hpp"
+#include "Config.hpp"
+
+/// What a ray under the cursor lands on first.
+/// The island goes through its heightfield pyramid, the ocean is solved from
+/// the analytic wave function inside the slab the waves can reach, and boats
+/// are taken from the spatial index cells the ray crosses then slab tested
+/// against their oriented box. No triangle is ever looked at, and boats away
+/// from the ray are never touched, whatever the fleet size.
+class Picking {
+public:
+  enum Target {
+    NOTHING,
+    GROUND,
+    OCEAN,
+    BOAT
+  };
+
+  struct Hit {
+    Target target;
+    Vector3f point;
+    float distance;   // Along the ray, in direction lengths
+    int id;           // Component handle for boats, -1 otherwise
+  };
+
+  /// Nearest of the three within `far`, `ground` may be null
+  static Hit pick(const Ray &ray, float far, const Heightfield *ground, const SpatialIndex &index,
+                  const Components &components);
+
+  static bool ground(const Ray &ray, float far, const Heightfield &heightfield, float &t);
+
+  static bool ocean(const Ray &ray, float far, float &t);
+
+  /// Boats are found in `index`, their boxes read live from `components`
+  static bool boats(const Ray &ray, float far, const SpatialIndex &index, const Components &components, float &t,
+                    int &id);
+};
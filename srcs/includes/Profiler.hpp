@@ -0,0 +1,78 @@
+//
+//  Profiler.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Config.hpp"
+
+/// Frame profiler, records timed scopes into one ring buffer per job thread.
+/// Only compiled in when PROFILING is defined (Debug builds or -DPROFILING=ON),
+/// PROFILE_SCOPE expands to nothing otherwise.
+/// Rings are written without locks by their own thread, so exportTrace() must
+/// run on the main thread between two ticks, when no job is running.
+class Profiler {
+public:
+  static Profiler &getInstance() {
+    static Profiler instance;
+    return instance;
+  }
+
+  /// Microseconds since the profiler started
+  long long now() const;
+
+  /// Records a scope of the calling thread, name must outlive the profiler
+  void record(const char *name, long long begin, long long end, unsigned int depth);
+
+  /// Writes every recorded scope as Chrome trace events (chrome://tracing, Perfetto)
+  bool exportTrace(const std::string &path = PROFILER_TRACE_FILE) const;
+
+  Profiler(const Profiler &) = delete;
+
+  Profiler &operator=(const Profiler &) = delete;
+
+private:
+  struct Event {
+    const char *name;
+    long long begin, end;
+    unsigned int depth;
+  };
+
+  struct Ring {
+    std::unique_ptr<Event[]> events;
+    size_t next = 0;
+    bool wrapped = false;
+  };
+
+  Profiler();
+
+  std::chrono::steady_clock::time_point _epoch;
+  std::vector<Ring> _rings;
+};
+
+/// Times its own lifetime
+class ProfileScope {
+public:
+  explicit ProfileScope(const char *name);
+
+  ~ProfileScope();
+
+private:
+  const char *_name;
+  long long _begin;
+  static thread_local unsigned int _depth;
+};
+
+#ifdef PROFILING
+# define PROFILE_CONCAT_(a, b) a##b
+# define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+# define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(name)
+#else
+# define PROFILE_SCOPE(name)
+#endif
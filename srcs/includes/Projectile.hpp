@@ -10,6 +10,7 @@
 #include "../helpers/Displayable.hpp"
 #include "../helpers/Axes.hpp"
 #include "../helpers/Alive.hpp"
+#include "Components.hpp"
 
 extern const float g;
 
@@ -18,7 +19,11 @@ public:
   //Typedef
   typedef std::shared_ptr<Projectile> Ptr;
 
-  explicit Projectile(float, Vector3f, Vector3f, Color c = Color(255, 0, 0));
+  explicit Projectile(float, Vector3f, Vector3f, CollisionLayer, Color c = Color(255, 0, 0));
+
+  ~Projectile();
+
+  void detect() override;
 
   void update() override;
 
@@ -27,8 +32,12 @@ public:
   void updateShape(float);
 
 private:
+  Shape sphere(float radius, int slices) const;
+
   Color _color;
-  float _startT;
-  Vector3f _start;
-  Vector3f _velocity;
+  Components::Handle _handle;
+  float _lastCheck;
+  Vector3f _lastPosition;   // Where the previous check left the shell, the ground is tested along the way
+  std::vector<Shapes> _levels;    // Coarser spheres, _levels[k] is level k + 1
+  mutable int _lod;               // Level drawn last frame
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+//
+//  Settings.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <string>
+
+/// Tuning knobs that used to be compile-time constants in Config.hpp.
+/// The Config.hpp macros now read Settings::current, a plain global, so hot
+/// paths pay one load instead of an immediate. Values are meant to be set once
+/// at startup, from a preset, a file and the command line, in that order.
+struct Settings {
+  // GAME
+  int windowWidth = 600;
+  int windowHeight = 600;
+  float gameSpeed = 2.0f;
+  int frameRate = 60;               // 0 redraws as fast as possible
+
+  // COLLISIONS
+  float checkCollisionsEvery = 0.04f;
+
+  // BOATS
+  int maxBoats = 5;
+  int boatsPerGeneration = 2;
+  float boatGenerationDelta = 5.0f;
+
+  // CANNON
+  float shotTimer = 1.0f;
+  float defenceTimer = 5.0f;
+
+  // WAVES
+  int wavesTessellation = 64;
+
+  // MESHES
+  int sphereSlices = 20;            // Shells and cannon heads, slices and segments
+  float trajectoryStep = 0.01f;     // Seconds between two points of the trajectory preview
+  int bakeLighting = 1;             // Island shading worked out once at load, 0 lights it every frame
+
+  // GOVERNOR
+  float governorTargetMs = 0.0f;    // Update and draw work per frame, 0 turns the governor off
+
+  // JOBS
+  int jobWorkers = 0;       // 0 = one per core, minus the main thread
+
+  static Settings current;
+
+  /// low, medium, high or stress, medium being the defaults
+  static bool applyPreset(const std::string &name);
+
+  static bool set(const std::string &key, const std::string &value);
+
+  /// `key = value` lines, # starts a comment
+  static bool loadFile(const std::string &path);
+
+  /// Consumes --preset name, --config file and --set key=value, leaves the other arguments
+  static bool parseArguments(int &argc, char **argv);
+};
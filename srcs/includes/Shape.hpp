@@ -45,6 +45,8 @@ public:
   float _size;
   GLenum _mode;
   Color _color;
+  GLuint _list = 0;       // Replays the shape once Displayable::compile() ran, 0 draws it vertex by vertex
+  GLuint _litList = 0;    // Same with the lighting worked into the colors
 
   void applyColor() const;
 
@@ -55,12 +57,15 @@ public:
   explicit Shape(Triangles parts, const Vector3f &delta,
                  GLenum mode = GL_TRIANGLES, Color color = BLACK);
 
-  bool collideWith(BoundingBox other) const;
+  bool collideWith(const BoundingBox &other) const;
 
-  bool collideWith(Shape other) const;
+  bool collideWith(const Shape &other) const;
 
   void generateBoundingBox();
 
+  /// For shapes whose bounds are known without walking their triangles
+  void setBoundingBox(const BoundingBox &box);
+
   const BoundingBox get_boundingBox() const;
 
 };
\ No newline at end of file
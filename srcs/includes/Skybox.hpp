@@ -4,24 +4,39 @@
 
 #pragma once
 
+#include <array>
 #include <cmath>
+#include <vector>
 #include "../helpers/Glut.hpp"
 #include "../helpers/Displayable.hpp"
 #include "../helpers/SOIL.h"
+#include "JobSystem.hpp"
 
+/// Six images on one cubemap, drawn as a single indexed box.
+/// The constructor only queues the decoding on the job system, so it overlaps
+/// with building the rest of the scene. bake() waits for it and uploads.
 class Skybox : public Displayable {
 public:
 
   Skybox();
 
+  ~Skybox();
+
   void draw() const override;
 
+  void bake() override;
+
 private:
 
-  GLuint _texture[6]{};
-};
+  /// Resampled to SKYBOX_FACE_SIZE, every mip level follows the one before
+  struct Face {
+    std::vector<unsigned char> pixels;
+    bool loaded = false;
+  };
 
-class TextureLoader {
-public:
-  static GLuint loadTexture(const char *filename);
-};
\ No newline at end of file
+  void decode(int side);
+
+  std::array<Face, 6> _faces;
+  std::vector<JobSystem::Job> _decoding;
+  GLuint _cubemap = 0;
+};
@@ -0,0 +1,128 @@
+//
+//  SpatialIndex.hpp
+//  IslandDefense3D
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "Components.hpp"
+
+/// Uniform grid over the sea holding every live component, rebuilt each tick.
+/// Items are counting sorted by cell into flat arrays, so a query walks a few
+/// contiguous runs instead of every boat and shell. Cells are laid out on the
+/// xz plane, distances are measured in 3D. Items outside the grid are kept in
+/// its border cells. Ids are component handles, `mask` holds LAYER() bits.
+/// Positions and velocities are copied in, so queries never read the
+/// components of a handle that may have been reused since the build.
+class SpatialIndex {
+public:
+  explicit SpatialIndex(float extent = 1.0f, float cellSize = SPATIAL_CELL_SIZE);
+
+  void build(const Components &components);
+
+  size_t size() const;
+
+  /// Largest bounding sphere of the boxes on the layers in `mask`, as they were at the build
+  float reach(unsigned mask) const;
+
+  /// Up to `k` ids closest to `position` within `maxDistance`, nearest first, returns how many were found.
+  /// Works in a buffer the index keeps, so one caller at a time unlike the other queries
+  size_t nearest(const Vector3f &position, unsigned mask, float maxDistance, int *ids, size_t k) const;
+
+  /// Calls `visitor(id, position, velocity)` on every item within `radius`
+  template<class F>
+  void forEachInRadius(const Vector3f &position, float radius, unsigned mask, F visitor) const {
+    int x0 = cell(position.x - radius), x1 = cell(position.x + radius);
+    int z0 = cell(position.z - radius), z1 = cell(position.z + radius);
+    float radius2 = radius * radius;
+    for (int z = z0; z <= z1; ++z) {
+      for (int x = x0; x <= x1; ++x) {
+        int c = z * _cells + x;
+        for (int i = _starts[c]; i < _starts[c + 1]; ++i) {
+          Vector3f d = _positions[i] - position;
+          if ((mask & LAYER(_layers[i])) && d.x * d.x + d.y * d.y + d.z * d.z <= radius2) {
+            visitor(_ids[i], _positions[i], _velocities[i]);
+          }
+        }
+      }
+    }
+  }
+
+  /// Calls `visitor(id, position, velocity)` on every item within `range` of `apex` and less than
+  /// `angle` degrees away from `axis`, which has to be normalized
+  template<class F>
+  void forEachInCone(const Vector3f &apex, const Vector3f &axis, float angle, float range, unsigned mask,
+                     F visitor) const {
+    float cosine = std::cos(angle * static_cast<float>(M_PI) / 180.0f);
+    float cosine2 = cosine * cosine;
+    forEachInRadius(apex, range, mask, [&](int id, const Vector3f &position, const Vector3f &velocity) {
+      // Compared squared, the sign of the projection decides for wide cones
+      Vector3f d = position - apex;
+      float along = d.x * axis.x + d.y * axis.y + d.z * axis.z;
+      float length2 = d.x * d.x + d.y * d.y + d.z * d.z;
+      if (along >= 0.0f ? cosine < 0.0f || along * along >= cosine2 * length2
+                        : cosine < 0.0f && along * along <= cosine2 * length2) {
+        visitor(id, position, velocity);
+      }
+    });
+  }
+
+  /// Calls `visitor(id, position, velocity)` on the items of every cell that comes within `radius`
+  /// of the segment on the xz plane. Rows are walked one after the other, each over the run of
+  /// cells the segment crosses there, so no cell is visited twice; the visitor does the exact test.
+  template<class F>
+  void forEachAlongSegment(const Vector3f &from, const Vector3f &to, float radius, unsigned mask,
+                           F visitor) const {
+    const float infinity = std::numeric_limits<float>::infinity();
+    float dx = to.x - from.x, dz = to.z - from.z;
+    int z0 = cell(std::min(from.z, to.z) - radius), z1 = cell(std::max(from.z, to.z) + radius);
+    for (int z = z0; z <= z1; ++z) {
+      // Part of the segment within `radius` of the row, border rows also hold what lies past them
+      float low = z == 0 ? -infinity : z * _cellSize - _extent - radius;
+      float high = z == _cells - 1 ? infinity : (z + 1) * _cellSize - _extent + radius;
+      float t0 = 0.0f, t1 = 1.0f;
+      if (dz == 0.0f) {
+        if (from.z < low || from.z > high) {
+          continue;
+        }
+      } else {
+        float ta = (low - from.z) / dz, tb = (high - from.z) / dz;
+        t0 = std::max(t0, std::min(ta, tb));
+        t1 = std::min(t1, std::max(ta, tb));
+        if (t0 > t1) {
+          continue;
+        }
+      }
+      float xa = from.x + dx * t0, xb = from.x + dx * t1;
+      int x0 = cell(std::min(xa, xb) - radius), x1 = cell(std::max(xa, xb) + radius);
+      for (int i = _starts[z * _cells + x0]; i < _starts[z * _cells + x1 + 1]; ++i) {
+        if (mask & LAYER(_layers[i])) {
+          visitor(_ids[i], _positions[i], _velocities[i]);
+        }
+      }
+    }
+  }
+
+private:
+  int cell(float coordinate) const;
+
+  float _extent;
+  float _cellSize;
+  int _cells;                         // Per side
+  std::vector<int> _starts;           // First item of every cell, one past the last at the end
+  std::vector<int> _ids;
+  std::vector<Vector3f> _positions;
+  std::vector<Vector3f> _velocities;
+  std::vector<CollisionLayer> _layers;
+  std::array<float, COLLISION_LAYERS_EOF> _reach;
+  std::vector<int> _scratch;          // Cell of every live component while building
+  std::vector<int> _next;             // Next free item of every cell while building
+  mutable std::vector<std::pair<float, int> > _best;  // Candidates of the running nearest() query
+};
@@ -7,12 +7,17 @@
 
 #pragma once
 
+#include <vector>
 #include "../helpers/Displayable.hpp"
 #include "Config.hpp"
 
 class Stats : public Displayable {
 private:
   Color _color;
+  mutable std::vector<float> _history;
+
+  /// Percentiles, per entity times and counters, toggled with 'o'
+  void drawOverlay(int h) const;
 
 public:
   explicit Stats(const Color &color = YELLOW);
@@ -14,6 +14,8 @@ public:
 
   void draw() const override;
 
+  void prepare() override;
+
   void update() override;
 
   static float computeHeight(float x, float z);
@@ -22,6 +24,9 @@ public:
 
   static float maxHeight();
 
+  /// Bound on computeHeight() whatever the time, the sum of the wave amplitudes
+  static float amplitude();
+
   void doubleVertices();
 
   void halveSegments();
@@ -33,11 +38,17 @@ public:
 
 private:
 
+  /// Vertices and chunk shapes for the current tessellation, the heights are left to animate()
+  void generateGrid();
+
+  void animate();
+
   static float sineNormal(float x, float z, float wavelength, float amplitude, float kx, float kz);
 
   static float sineWave(float x, float z, float wavelength, float amplitude, float kx, float kz);
 
   bool _animate;
   Vertices _vertices;
+  std::vector<float> _rowHeights;
   int _tess;
 };
\ No newline at end of file